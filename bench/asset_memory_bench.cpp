@@ -0,0 +1,82 @@
+// Heap held by the latest-state index per 100k assets: records kept as
+// minijson::Value trees (the previous AssetIndex representation) vs
+// AssetRecord with os / cpu_model / agent_version / mount interned.
+//
+//   bench_asset_memory [--assets 100000]
+#include "asset_index.hpp"
+#include "file_store.hpp"
+#include "inventory.hpp"
+#include "bench_common.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The index as it was before interning.
+struct ValueIndex {
+    struct Entry {
+        minijson::Value record;
+        std::vector<uint64_t> history;
+    };
+    std::unordered_map<std::string, size_t> by_id;
+    std::vector<Entry> entries;
+
+    void load(const std::string& path) {
+        filestore::for_each_record(path, [&](std::string_view line, uint64_t off) {
+            auto doc = minijson::Document::parse(line);
+            std::string why;
+            if (!inventory::validate_asset_schema(doc.root(), why)) return;
+            minijson::Value v = doc.root().to_value();
+            auto it = by_id.find(v.at("asset_id").s);
+            if (it == by_id.end()) {
+                by_id.emplace(v.at("asset_id").s, entries.size());
+                entries.push_back(Entry{std::move(v), {off}});
+            } else {
+                entries[it->second].record = std::move(v);
+                entries[it->second].history.push_back(off);
+            }
+        });
+    }
+};
+
+int main(int argc, char** argv) {
+    long assets = 100000;
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--assets" && i + 1 < argc) assets = std::atol(argv[++i]);
+    }
+    if (assets < 1) assets = 1;
+
+    auto dir = std::filesystem::temp_directory_path() / "asset_bench_memory";
+    std::filesystem::create_directories(dir);
+    const std::string path = (dir / "assets.jsonl").string();
+    benchutil::write_store(path, assets, assets);
+
+    long long base = benchutil::g_alloc.live;
+    auto t0 = benchutil::Clock::now();
+    auto* before = new ValueIndex;
+    before->load(path);
+    double before_ms = benchutil::ms_since(t0);
+    long long before_bytes = benchutil::g_alloc.live - base;
+    delete before;
+
+    base = benchutil::g_alloc.live;
+    t0 = benchutil::Clock::now();
+    auto* after = new assetindex::AssetIndex;
+    after->load(path);
+    double after_ms = benchutil::ms_since(t0);
+    long long after_bytes = benchutil::g_alloc.live - base;
+
+    const double per100k = 100000.0 / (double)assets / 1048576.0;
+    std::printf("%ld assets, %zu interned strings\n", assets, after->strings().size());
+    std::printf("%-22s %14s %16s %12s\n", "representation", "bytes/asset", "MB per 100k", "load (ms)");
+    std::printf("%-22s %14.0f %16.1f %12.0f\n", "minijson::Value", (double)before_bytes / assets, before_bytes * per100k, before_ms);
+    std::printf("%-22s %14.0f %16.1f %12.0f\n", "AssetRecord+interning", (double)after_bytes / assets, after_bytes * per100k, after_ms);
+    delete after;
+
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    return 0;
+}
@@ -0,0 +1,32 @@
+// Counting replacement for the global operator new/delete, linked into the
+// benches that report allocations or heap use (see benchutil::g_alloc).
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace benchutil { AllocCounters g_alloc; }
+
+using benchutil::g_alloc;
+
+// Size-prefixed so operator delete can account for freed bytes.
+void* operator new(size_t n) {
+    void* p = std::malloc(n + 16);
+    if (!p) throw std::bad_alloc();
+    *(size_t*)p = n;
+    g_alloc.allocs.fetch_add(1, std::memory_order_relaxed);
+    g_alloc.bytes.fetch_add(n, std::memory_order_relaxed);
+    long long live = g_alloc.live.fetch_add((long long)n, std::memory_order_relaxed) + (long long)n;
+    long long peak = g_alloc.peak.load(std::memory_order_relaxed);
+    while (live > peak && !g_alloc.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return (char*)p + 16;
+}
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    char* base = (char*)p - 16;
+    g_alloc.live.fetch_sub((long long)*(size_t*)base, std::memory_order_relaxed);
+    std::free(base);
+}
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { operator delete(p); }
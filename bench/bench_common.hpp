@@ -0,0 +1,152 @@
+#pragma once
+// Shared helpers for the bench/ executables.
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace benchutil {
+
+// Heap counters kept by the counting operator new/delete in bench_alloc.cpp;
+// only benches that link that file may use them.
+struct AllocCounters {
+    std::atomic<size_t> allocs{0};   // operator new calls
+    std::atomic<size_t> bytes{0};    // bytes requested by them
+    std::atomic<long long> live{0};  // bytes allocated and not yet freed
+    std::atomic<long long> peak{0};  // highest live; reset it to live to measure from a point
+};
+extern AllocCounters g_alloc;
+
+// Same shape as assets/preview_sent.json, compact.
+inline const char* sample_payload() {
+    return "{\"asset_id\":\"asset-deadbeef\",\"hostname\":\"roberto-PC\",\"os\":\"Windows 10 (build 19045)\","
+           "\"cpu_model\":\"Intel(R) Core(TM) i5-8250U CPU @ 1.60GHz\",\"cpu_cores\":8,\"ram_total_mb\":8192,"
+           "\"disks\":[{\"mount\":\"C:\\\\\",\"total_gb\":237,\"free_gb\":58},{\"mount\":\"D:\\\\\",\"total_gb\":931,\"free_gb\":402}],"
+           "\"timestamp_utc\":\"2026-02-13T06:23:12Z\",\"agent_version\":\"1.0.0\"}";
+}
+
+using Clock = std::chrono::steady_clock;
+
+inline double ms_since(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// One valid compact store record; record i belongs to asset i % assets.
+inline std::string record_line(long i, long assets) {
+    static const char* os[] = {"Windows 10 (build 19045)", "Windows 11 (build 22631)", "Ubuntu 22.04.4 LTS", "Debian GNU/Linux 12 (bookworm)"};
+    static const char* cpu[] = {"Intel(R) Core(TM) i5-8250U CPU @ 1.60GHz", "AMD Ryzen 7 5800X 8-Core Processor", "Intel(R) Xeon(R) Gold 6226R CPU @ 2.90GHz"};
+    long a = i % assets;
+    // Measured first, then printed into a string of exactly that size.
+    auto print = [&](char* buf, size_t size) {
+        return std::snprintf(buf, size,
+            "{\"agent_version\":\"1.0.%ld\",\"asset_id\":\"asset-%08lx\",\"cpu_cores\":%ld,\"cpu_model\":\"%s\","
+            "\"disks\":[{\"free_gb\":%ld,\"mount\":\"C:\\\\\",\"total_gb\":237},{\"free_gb\":402,\"mount\":\"D:\\\\\",\"total_gb\":931}],"
+            "\"hostname\":\"host-%ld\",\"os\":\"%s\",\"ram_total_mb\":%ld,\"timestamp_utc\":\"2026-02-%02ldT06:23:12Z\"}",
+            i / assets % 3, a, 2 + a % 15, cpu[a % 3], 10 + i % 200, a, os[a % 4], 4096L << (a % 3), 1 + i / assets % 28);
+    };
+    std::string out((size_t)print(nullptr, 0), '\0');
+    print(&out[0], out.size() + 1);
+    return out;
+}
+
+// Writes a JSONL store of `lines` valid records cycling over `assets` ids,
+// appending when append is set.
+inline void write_store(const std::string& path, long lines, long assets, bool append = false) {
+    std::ofstream f(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    for (long i=0;i<lines;i++) {
+        std::string line = record_line(i, assets);
+        line += '\n';
+        f.write(line.data(), (std::streamsize)line.size());
+    }
+}
+
+// Comma-separated list of counts, e.g. "10000,100000".
+inline std::vector<long> parse_counts(const std::string& s) {
+    std::vector<long> out;
+    for (size_t p = 0; p < s.size();) {
+        size_t q = s.find(',', p);
+        if (q == std::string::npos) q = s.size();
+        long n = std::atol(s.substr(p, q - p).c_str());
+        if (n > 0) out.push_back(n);
+        p = q + 1;
+    }
+    return out;
+}
+
+// Machine-readable results for --json PATH, one document per run:
+//   {"bench":"..","timestamp_utc":"..","config":{..},
+//    "results":[{"name":"..","value":..,"unit":".."},..]}
+// Names are stable across runs, so two files can be joined on them.
+class JsonReport {
+public:
+    explicit JsonReport(std::string bench) : bench_(std::move(bench)) {}
+
+    void config(const std::string& key, const std::string& value) { config_.push_back({key, quote(value)}); }
+    void config(const std::string& key, double value) { config_.push_back({key, number(value)}); }
+
+    void add(const std::string& name, double value, const char* unit) {
+        results_.push_back("{\"name\":" + quote(name) + ",\"value\":" + number(value) + ",\"unit\":" + quote(unit) + "}");
+    }
+
+    // Does nothing for an empty path.
+    bool write(const std::string& path) const {
+        if (path.empty()) return true;
+        std::time_t t = std::time(nullptr);
+        std::tm tm{};
+#ifdef _WIN32
+        gmtime_s(&tm, &t);
+#else
+        gmtime_r(&t, &tm);
+#endif
+        char ts[32];
+        std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        std::string out = "{\"bench\":" + quote(bench_) + ",\"timestamp_utc\":" + quote(ts) + ",\"config\":{";
+        for (size_t i=0;i<config_.size();i++) {
+            if (i) out += ',';
+            out += quote(config_[i].first) + ":" + config_[i].second;
+        }
+        out += "},\"results\":[";
+        for (size_t i=0;i<results_.size();i++) {
+            out += i ? ",\n  " : "\n  ";
+            out += results_[i];
+        }
+        out += "\n]}\n";
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        f << out;
+        if (!f) {
+            std::fprintf(stderr, "cannot write %s\n", path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static std::string quote(const std::string& s) {
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') out += '\\';
+            if ((unsigned char)c < 0x20) continue;
+            out += c;
+        }
+        return out + "\"";
+    }
+    // Integral values (counters, sizes) print exactly; others round-trip.
+    static std::string number(double v) {
+        char buf[32];
+        if (v == std::floor(v) && std::fabs(v) < 9.007199254740992e15) std::snprintf(buf, sizeof(buf), "%.0f", v);
+        else std::snprintf(buf, sizeof(buf), "%.17g", v);
+        return buf;
+    }
+
+    std::string bench_;
+    std::vector<std::pair<std::string, std::string>> config_;
+    std::vector<std::string> results_;
+};
+
+} // namespace benchutil
@@ -0,0 +1,97 @@
+// Bytes on disk and full-scan throughput for the JSONL store vs the binary
+// record format (assetbin), plus a JSONL -> binary -> JSONL round trip check.
+//
+//   bench_binary_store [--lines 1000000] [--assets 50000] [--keep]
+#include "asset_binary.hpp"
+#include "file_store.hpp"
+#include "mini_json.hpp"
+#include "bench_common.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+static std::string slurp(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char** argv) {
+    long lines = 1000000, assets = 50000;
+    bool keep = false;
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--lines" && i + 1 < argc) lines = std::atol(argv[++i]);
+        else if (a == "--assets" && i + 1 < argc) assets = std::atol(argv[++i]);
+        else if (a == "--keep") keep = true;
+    }
+    if (assets < 1) assets = 1;
+
+    auto dir = std::filesystem::temp_directory_path() / "asset_bench_binary";
+    std::filesystem::create_directories(dir);
+    const std::string jsonl = (dir / "assets.jsonl").string();
+    const std::string bin = (dir / "assets.bin").string();
+    const std::string back = (dir / "roundtrip.jsonl").string();
+    benchutil::write_store(jsonl, lines, assets);
+
+    size_t n = 0;
+    std::string err;
+    auto t0 = benchutil::Clock::now();
+    if (!assetbin::jsonl_to_binary(jsonl, bin, n, err)) { std::fprintf(stderr, "%s\n", err.c_str()); return 1; }
+    double encode_ms = benchutil::ms_since(t0);
+    t0 = benchutil::Clock::now();
+    if (!assetbin::binary_to_jsonl(bin, back, n, err)) { std::fprintf(stderr, "%s\n", err.c_str()); return 1; }
+    double decode_ms = benchutil::ms_since(t0);
+    bool identical = slurp(jsonl) == slurp(back);
+
+    const double jsonl_mb = std::filesystem::file_size(jsonl) / 1048576.0;
+    const double bin_mb = std::filesystem::file_size(bin) / 1048576.0;
+
+    // Full scans reading the fields a report would use. Both files are in
+    // memory before timing starts (refresh() touches every mapped byte).
+    double ram_json = 0, ram_bin = 0;
+    filestore::MappedLines m(jsonl);
+    if (!m.refresh(err)) { std::fprintf(stderr, "%s\n", err.c_str()); return 1; }
+    t0 = benchutil::Clock::now();
+    size_t disks_json = 0;
+    for (size_t i=0;i<m.size();i++) {
+        auto doc = minijson::Document::parse(m.line(i));
+        const auto& r = doc.root();
+        ram_json += r.at("ram_total_mb").num;
+        disks_json += r.at("disks").size() + r.at("os").string().size() + r.at("cpu_model").string().size();
+    }
+    double json_ms = benchutil::ms_since(t0);
+
+    std::string data = slurp(bin);
+    assetbin::Decoder dec;
+    assetbin::Record rec;
+    if (!dec.open(data, err)) { std::fprintf(stderr, "%s\n", err.c_str()); return 1; }
+    t0 = benchutil::Clock::now();
+    size_t disks_bin = 0, records = 0;
+    while (dec.next(rec, err)) {
+        ram_bin += rec.ram_total_mb;
+        disks_bin += rec.disks.size() + rec.os.size() + rec.cpu_model.size();
+        records++;
+    }
+    double bin_ms = benchutil::ms_since(t0);
+    if (!err.empty() || ram_bin != ram_json || disks_bin != disks_json) {
+        std::fprintf(stderr, "scan mismatch %s\n", err.c_str());
+        return 1;
+    }
+
+    std::printf("%ld records, %ld assets; round trip JSONL -> binary -> JSONL identical: %s\n",
+                lines, assets, identical ? "yes" : "NO");
+    std::printf("%-8s %12s %14s %14s\n", "format", "size (MB)", "scan (ms)", "records/s");
+    std::printf("%-8s %12.1f %14.1f %14.0f\n", "jsonl", jsonl_mb, json_ms, m.size() / (json_ms / 1000.0));
+    std::printf("%-8s %12.1f %14.1f %14.0f\n", "binary", bin_mb, bin_ms, records / (bin_ms / 1000.0));
+    std::printf("size ratio %.2fx, scan speedup %.1fx; convert to binary %.0f ms, back to JSONL %.0f ms\n",
+                jsonl_mb / bin_mb, json_ms / bin_ms, encode_ms, decode_ms);
+
+    if (!keep) {
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    }
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+// Regression numbers for the server's hot paths, one row per measurement:
+// minijson parse / stringify and schema validation on agent-shaped records,
+// filestore::append_line, AppendWriter::append, read_lines and a MappedLines
+// scan at each store size, and /export.csv rendering from the index.
+// --json writes the same rows as machine-readable results (see
+// benchutil::JsonReport) so runs on different commits can be compared.
+//
+//   bench_hotpaths [--lines 10000,100000,1000000] [--assets 50000] [--docs 20000]
+//                  [--skip-store] [--json PATH]
+//
+// append_line opens and closes the file per call, so 10M lines takes
+// minutes; the other store rows scale linearly.
+#include "mini_json.hpp"
+#include "inventory.hpp"
+#include "file_store.hpp"
+#include "asset_index.hpp"
+#include "bench_common.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using benchutil::Clock;
+using benchutil::ms_since;
+
+static benchutil::JsonReport g_report("hotpaths");
+
+// name, then per-item time and throughput; MB/s is left out when bytes is 0.
+static void row(const std::string& name, double ms, double items, double bytes) {
+    const double ns = ms * 1e6 / items;
+    const double mbs = bytes > 0 ? bytes / 1048576.0 / (ms / 1000.0) : 0;
+    char mb[16] = "-";
+    if (bytes > 0) std::snprintf(mb, sizeof(mb), "%.1f", mbs);
+    std::printf("%-34s %12.1f %12.0f %14.0f %10s\n", name.c_str(), ms, ns, items / (ms / 1000.0), mb);
+    g_report.add(name + ".ns_per_item", ns, "ns");
+    g_report.add(name + ".items_per_s", items / (ms / 1000.0), "1/s");
+    if (bytes > 0) g_report.add(name + ".mb_per_s", mbs, "MB/s");
+}
+
+static bool json_rows(long docs) {
+    std::vector<std::string> compact, pretty;
+    size_t compact_bytes = 0, pretty_bytes = 0;
+    for (long i=0;i<docs;i++) {
+        compact.push_back(benchutil::record_line(i, docs));
+        // what asset_agent sends
+        pretty.push_back(minijson::stringify(minijson::parse(compact.back()), true));
+        compact_bytes += compact.back().size();
+        pretty_bytes += pretty.back().size();
+    }
+
+    size_t sink = 0;
+    std::string why;
+    std::vector<minijson::Value> values(docs);
+    auto t0 = Clock::now();
+    for (long i=0;i<docs;i++) values[i] = minijson::parse(pretty[i]);
+    row("json.parse.value", ms_since(t0), (double)docs, (double)pretty_bytes);
+
+    t0 = Clock::now();
+    for (long i=0;i<docs;i++) sink += minijson::Document::parse(pretty[i]).root().size();
+    row("json.parse.document", ms_since(t0), (double)docs, (double)pretty_bytes);
+
+    t0 = Clock::now();
+    for (long i=0;i<docs;i++) sink += minijson::stringify(values[i], false).size();
+    row("json.stringify.compact", ms_since(t0), (double)docs, (double)compact_bytes);
+
+    t0 = Clock::now();
+    for (long i=0;i<docs;i++) sink += minijson::stringify(values[i], true).size();
+    row("json.stringify.pretty", ms_since(t0), (double)docs, (double)pretty_bytes);
+
+    t0 = Clock::now();
+    for (long i=0;i<docs;i++) {
+        if (!inventory::validate_asset_schema(values[i], why)) { std::fprintf(stderr, "invalid: %s\n", why.c_str()); return false; }
+    }
+    row("validate.value", ms_since(t0), (double)docs, 0);
+
+    std::vector<minijson::Document> nodes;
+    nodes.reserve(docs);
+    for (long i=0;i<docs;i++) nodes.push_back(minijson::Document::parse(compact[i]));
+    t0 = Clock::now();
+    for (long i=0;i<docs;i++) {
+        if (!inventory::validate_asset_schema(nodes[i].root(), why)) { std::fprintf(stderr, "invalid: %s\n", why.c_str()); return false; }
+    }
+    row("validate.document", ms_since(t0), (double)docs, 0);
+
+    t0 = Clock::now();
+    for (long i=0;i<docs;i++) {
+        if (!inventory::validate_asset_json(pretty[i], why)) { std::fprintf(stderr, "invalid: %s\n", why.c_str()); return false; }
+    }
+    row("validate.events", ms_since(t0), (double)docs, (double)pretty_bytes);
+
+    if (sink == 42) std::printf(" ");
+    return true;
+}
+
+static bool store_rows(const std::filesystem::path& dir, long lines, long assets) {
+    const std::string tag = "/" + std::to_string(lines);
+    std::vector<std::string> records;
+    records.reserve(lines);
+    double bytes = 0;
+    for (long i=0;i<lines;i++) {
+        records.push_back(benchutil::record_line(i, assets));
+        bytes += (double)records.back().size() + 1;
+    }
+
+    const std::string path = (dir / "append_line.jsonl").string();
+    std::string err;
+    auto t0 = Clock::now();
+    for (const auto& r : records) {
+        if (!filestore::append_line(path, r, err)) { std::fprintf(stderr, "%s\n", err.c_str()); return false; }
+    }
+    row("store.append_line" + tag, ms_since(t0), (double)lines, bytes);
+
+    {
+        const std::string wpath = (dir / "writer.jsonl").string();
+        filestore::AppendWriter writer(wpath, filestore::WriterOptions{});
+        if (!writer.open(err)) { std::fprintf(stderr, "%s\n", err.c_str()); return false; }
+        t0 = Clock::now();
+        for (const auto& r : records) {
+            if (!writer.append(r, err)) { std::fprintf(stderr, "%s\n", err.c_str()); return false; }
+        }
+        row("store.writer_append" + tag, ms_since(t0), (double)lines, bytes);
+    }
+    records.clear();
+    records.shrink_to_fit();
+
+    t0 = Clock::now();
+    size_t n = filestore::read_lines(path).size();
+    row("store.read_lines" + tag, ms_since(t0), (double)n, bytes);
+
+    t0 = Clock::now();
+    filestore::MappedLines m(path);
+    if (!m.refresh(err)) { std::fprintf(stderr, "%s\n", err.c_str()); return false; }
+    size_t sink = 0;
+    for (size_t i=0;i<m.size();i++) sink += m.line(i).size();
+    row("store.mapped_scan" + tag, ms_since(t0), (double)m.size(), bytes);
+    if (n != (size_t)lines || m.size() != (size_t)lines) {
+        std::fprintf(stderr, "line count mismatch: %zu / %zu, expected %ld (%zu)\n", n, m.size(), lines, sink);
+        return false;
+    }
+
+    assetindex::AssetIndex index;
+    t0 = Clock::now();
+    index.load(path);
+    row("index.load" + tag, ms_since(t0), (double)lines, bytes);
+
+    t0 = Clock::now();
+    std::string csv = index.to_csv();
+    row("export.csv" + tag, ms_since(t0), (double)index.size(), (double)csv.size());
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string lines_arg = "10000,100000,1000000", json_path;
+    long assets = 50000;
+    long docs = 20000;
+    bool skip_store = false;
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--lines" && i + 1 < argc) lines_arg = argv[++i];
+        else if (a == "--assets" && i + 1 < argc) assets = std::atol(argv[++i]);
+        else if (a == "--docs" && i + 1 < argc) docs = std::atol(argv[++i]);
+        else if (a == "--skip-store") skip_store = true;
+        else if (a == "--json" && i + 1 < argc) json_path = argv[++i];
+    }
+    if (assets < 1) assets = 1;
+    if (docs < 1) docs = 1;
+    g_report.config("lines", lines_arg);
+    g_report.config("assets", (double)assets);
+    g_report.config("docs", (double)docs);
+    g_report.config("scan_impl", minijson::scan_impl_name(minijson::scan_impl()));
+
+    std::printf("%-34s %12s %12s %14s %10s\n", "", "total (ms)", "ns/item", "items/s", "MB/s");
+    if (!json_rows(docs)) return 1;
+
+    if (!skip_store) {
+        auto dir = std::filesystem::temp_directory_path() / "asset_bench_hotpaths";
+        for (long lines : benchutil::parse_counts(lines_arg)) {
+            std::filesystem::remove_all(dir);
+            std::filesystem::create_directories(dir);
+            if (!store_rows(dir, lines, std::min(lines, assets))) return 1;
+        }
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    }
+    return g_report.write(json_path) ? 0 : 1;
+}
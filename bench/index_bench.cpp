@@ -0,0 +1,100 @@
+// Compares serving GET /api/assets by re-reading the whole JSONL store (the
+// original json_array_from_store) with serving it from the AssetIndex, and
+// the full list with one filtered page (assetindex::query_json).
+//
+//   bench_index [--lines 1000000] [--assets 50000] [--keep]
+#include "asset_index.hpp"
+#include "asset_query.hpp"
+#include "file_store.hpp"
+#include "mini_json.hpp"
+#include "bench_common.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using benchutil::Clock;
+using benchutil::ms_since;
+
+int main(int argc, char** argv) {
+    long lines = 1000000, assets = 50000;
+    bool keep = false;
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--lines" && i + 1 < argc) lines = std::atol(argv[++i]);
+        else if (a == "--assets" && i + 1 < argc) assets = std::atol(argv[++i]);
+        else if (a == "--keep") keep = true;
+    }
+    if (assets < 1) assets = 1;
+
+    auto dir = std::filesystem::temp_directory_path() / "asset_bench_index";
+    std::filesystem::create_directories(dir);
+    std::string path = (dir / "assets.jsonl").string();
+
+    auto t0 = Clock::now();
+    benchutil::write_store(path, lines, assets);
+    std::printf("generated %ld lines / %ld assets in %.0f ms (%.1f MB)\n", lines, assets, ms_since(t0),
+                std::filesystem::file_size(path) / 1048576.0);
+
+    // Original path: every GET reads and parses the whole history.
+    t0 = Clock::now();
+    size_t cold_bytes;
+    {
+        auto all = filestore::read_lines(path);
+        std::vector<minijson::Value> items;
+        for (const auto& ln : all) {
+            try { items.push_back(minijson::parse(ln)); } catch (...) {}
+        }
+        cold_bytes = minijson::stringify(minijson::Value::array(std::move(items)), true).size();
+    }
+    double cold_ms = ms_since(t0);
+
+    t0 = Clock::now();
+    assetindex::AssetIndex index;
+    size_t indexed = index.load(path);
+    double load_ms = ms_since(t0);
+
+    const int reps = 5;
+    size_t hot_bytes = 0;
+    t0 = Clock::now();
+    for (int r=0;r<reps;r++) hot_bytes = index.to_json_array(true).size();
+    double hot_ms = ms_since(t0) / reps;
+
+    std::printf("%-28s %12s %14s\n", "", "time (ms)", "body (bytes)");
+    std::printf("%-28s %12.1f %14zu\n", "cold read per GET", cold_ms, cold_bytes);
+    std::printf("%-28s %12.1f %14s\n", "index build (startup, once)", load_ms, "-");
+    std::printf("%-28s %12.1f %14zu\n", "indexed GET", hot_ms, hot_bytes);
+    std::printf("indexed %zu records into %zu assets; speedup per GET: %.1fx\n", indexed, index.size(), cold_ms / hot_ms);
+
+    // Pages of 100, as the dashboard requests them.
+    struct Case { const char* name; assetindex::AssetQuery q; };
+    std::vector<Case> cases(4);
+    cases[0].name = "page, first-seen order";
+    cases[1].name = "page, -timestamp_utc";
+    cases[1].q.sort = "-timestamp_utc";
+    cases[2].name = "page, hostname_prefix";
+    cases[2].q.sort = "hostname";
+    cases[2].q.hostname_prefix = "host-4";
+    cases[3].name = "page, os + low_disk_gb";
+    cases[3].q.os = "Ubuntu 22.04.4 LTS";
+    cases[3].q.low_disk_gb = 20;
+    std::printf("%-28s %12s %14s\n", "", "time (ms)", "body (bytes)");
+    for (const auto& c : cases) {
+        std::string body, err;
+        const int page_reps = 200;
+        t0 = Clock::now();
+        for (int r=0;r<page_reps;r++) {
+            body.clear();
+            assetindex::query_json(index, c.q, body, err);
+        }
+        std::printf("%-28s %12.3f %14zu\n", c.name, ms_since(t0) / page_reps, body.size());
+    }
+
+    if (!keep) {
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Allocation count, retained bytes and parse+validate time per document for
+// minijson::Value, the arena-backed minijson::Document and the tree-less
+// event parser (inventory::validate_asset_json).
+//
+//   bench_json_dom [--iterations N]
+#include "mini_json.hpp"
+#include "inventory.hpp"
+#include "bench_common.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+struct Stats {
+    size_t allocs = 0;
+    size_t alloc_bytes = 0;
+    long long retained = 0;
+};
+
+template <class F>
+static Stats measure(F&& f) {
+    size_t a0 = benchutil::g_alloc.allocs, b0 = benchutil::g_alloc.bytes;
+    long long l0 = benchutil::g_alloc.live;
+    Stats s;
+    f(s);
+    s.allocs = benchutil::g_alloc.allocs - a0;
+    s.alloc_bytes = benchutil::g_alloc.bytes - b0;
+    s.retained += benchutil::g_alloc.live - l0;
+    return s;
+}
+
+int main(int argc, char** argv) {
+    int iterations = 200000;
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--iterations" && i + 1 < argc) iterations = std::atoi(argv[++i]);
+    }
+    const std::string text = benchutil::sample_payload();
+    std::string why;
+
+    // Warm up the parsers' per-thread scratch buffers.
+    minijson::Document::parse(text);
+    inventory::validate_asset_json(text, why);
+
+    // One retained document of each kind: allocations and bytes held.
+    minijson::Value keep_v;
+    Stats sv = measure([&](Stats& s) {
+        keep_v = minijson::parse(text);
+        s.retained = (long long)sizeof(minijson::Value);
+    });
+    minijson::Document keep_d = minijson::Document::parse("null");
+    Stats sd = measure([&](Stats& s) {
+        keep_d = minijson::Document::parse(text);
+        s.retained = (long long)sizeof(minijson::Document);
+    });
+
+    Stats se = measure([&](Stats&) {
+        if (!inventory::validate_asset_json(text, why)) std::abort();
+    });
+
+    // Throughput: parse + validate, as the POST handler does.
+    auto t0 = benchutil::Clock::now();
+    for (int i=0;i<iterations;i++) {
+        auto v = minijson::parse(text);
+        if (!inventory::validate_asset_schema(v, why)) return 1;
+    }
+    double value_ms = benchutil::ms_since(t0);
+    t0 = benchutil::Clock::now();
+    for (int i=0;i<iterations;i++) {
+        auto d = minijson::Document::parse(text);
+        if (!inventory::validate_asset_schema(d.root(), why)) return 1;
+    }
+    double doc_ms = benchutil::ms_since(t0);
+    t0 = benchutil::Clock::now();
+    for (int i=0;i<iterations;i++) {
+        if (!inventory::validate_asset_json(text, why)) return 1;
+    }
+    double events_ms = benchutil::ms_since(t0);
+
+    std::printf("payload: %zu bytes, sizeof(Value)=%zu, sizeof(Node)=%zu, sizeof(Member)=%zu\n",
+                text.size(), sizeof(minijson::Value), sizeof(minijson::Node), sizeof(minijson::Member));
+    std::printf("%-10s %12s %16s %16s %14s\n", "repr", "allocs/doc", "alloc bytes/doc", "retained bytes", "ns/parse");
+    std::printf("%-10s %12zu %16zu %16lld %14.0f\n", "Value", sv.allocs, sv.alloc_bytes, sv.retained, value_ms * 1e6 / iterations);
+    std::printf("%-10s %12zu %16zu %16lld %14.0f\n", "Document", sd.allocs, sd.alloc_bytes, sd.retained, doc_ms * 1e6 / iterations);
+    std::printf("%-10s %12zu %16zu %16lld %14.0f\n", "events", se.allocs, se.alloc_bytes, se.retained, events_ms * 1e6 / iterations);
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Parser throughput (MB/s) for each byte-scanning implementation over
+// assets/preview_sent.json-shaped records, compact (as stored in the JSONL
+// store) and pretty-printed (as sent by asset_agent).
+//
+//   bench_json_scan [--records N] [--rounds R]
+#include "mini_json.hpp"
+#include "bench_common.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> make_records(int n, bool pretty) {
+    minijson::Value base = minijson::parse(benchutil::sample_payload());
+    std::vector<std::string> out;
+    out.reserve(n);
+    for (int i=0;i<n;i++) {
+        base.o["hostname"].s = "workstation-" + std::to_string(i) + ".corp.example.com";
+        base.o["asset_id"].s = "asset-" + std::to_string(0x9e3779b97f4a7c15ULL * (unsigned)(i + 1));
+        base.o["ram_total_mb"].num = 4096.0 * (1 + i % 8);
+        out.push_back(minijson::stringify(base, pretty));
+    }
+    return out;
+}
+
+template <class F>
+static double mb_per_s(const std::vector<std::string>& recs, int rounds, F&& parse_one) {
+    size_t bytes = 0;
+    for (const auto& r : recs) bytes += r.size();
+    auto t0 = benchutil::Clock::now();
+    for (int k=0;k<rounds;k++) for (const auto& r : recs) parse_one(r);
+    double ms = benchutil::ms_since(t0);
+    return (double)bytes * rounds / 1e6 / (ms / 1e3);
+}
+
+int main(int argc, char** argv) {
+    int records = 20000, rounds = 5;
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--records" && i + 1 < argc) records = std::atoi(argv[++i]);
+        else if (a == "--rounds" && i + 1 < argc) rounds = std::atoi(argv[++i]);
+    }
+
+    const minijson::ScanImpl detected = minijson::scan_impl();
+    std::printf("detected scan implementation: %s\n", minijson::scan_impl_name(detected));
+    std::printf("%-8s %-8s %14s %14s\n", "input", "impl", "Value MB/s", "Document MB/s");
+
+    for (bool pretty : {false, true}) {
+        auto recs = make_records(records, pretty);
+        std::string reference;
+        for (auto impl : {minijson::ScanImpl::Scalar, minijson::ScanImpl::SSE2, minijson::ScanImpl::AVX2}) {
+            if (!minijson::set_scan_impl(impl)) continue;
+            // All implementations must produce the same tree.
+            std::string check = minijson::stringify(minijson::parse(recs[records / 2]));
+            if (reference.empty()) reference = check;
+            else if (check != reference) { std::fprintf(stderr, "mismatch for %s\n", minijson::scan_impl_name(impl)); return 1; }
+
+            double v = mb_per_s(recs, rounds, [](const std::string& r) { minijson::parse(r); });
+            double d = mb_per_s(recs, rounds, [](const std::string& r) { minijson::Document::parse(r); });
+            std::printf("%-8s %-8s %14.1f %14.1f\n", pretty ? "pretty" : "compact", minijson::scan_impl_name(impl), v, d);
+        }
+    }
+    minijson::set_scan_impl(detected);
+    return 0;
+}
@@ -0,0 +1,148 @@
+// Serialisation throughput and allocations per document: the previous
+// ostringstream-based stringify, the current stringify (a Writer into a
+// fresh string) and a Writer appending into one reused buffer.
+//
+//   bench_json_write [--iterations N]
+#include "mini_json.hpp"
+#include "bench_common.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+// The serializer as it was before minijson::Writer, kept for comparison.
+namespace legacy {
+
+static std::string esc(const std::string& s) {
+    std::ostringstream o;
+    for (char c: s) {
+        switch (c) {
+            case '"': o << "\\\""; break;
+            case '\\': o << "\\\\"; break;
+            case '\b': o << "\\b"; break;
+            case '\f': o << "\\f"; break;
+            case '\n': o << "\\n"; break;
+            case '\r': o << "\\r"; break;
+            case '\t': o << "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) o << "?";
+                else o << c;
+        }
+    }
+    return o.str();
+}
+
+static void indent(std::ostringstream& o, int n) { for (int i=0;i<n;i++) o << ' '; }
+
+static std::string stringify(const minijson::Value& v, bool pretty, int indent_level = 0) {
+    using T = minijson::Value::Type;
+    std::ostringstream o;
+    switch (v.type) {
+        case T::Null: o << "null"; break;
+        case T::Bool: o << (v.b ? "true" : "false"); break;
+        case T::Number: o << std::setprecision(15) << v.num; break;
+        case T::String: o << "\"" << esc(v.s) << "\""; break;
+        case T::Array: {
+            o << "[";
+            if (!v.a.empty()) {
+                if (pretty) o << "\n";
+                for (size_t i=0;i<v.a.size(); ++i) {
+                    if (pretty) indent(o, indent_level + 2);
+                    o << legacy::stringify(v.a[i], pretty, indent_level + 2);
+                    if (i + 1 < v.a.size()) o << ",";
+                    if (pretty) o << "\n";
+                }
+                if (pretty) indent(o, indent_level);
+            }
+            o << "]";
+            break;
+        }
+        case T::Object: {
+            o << "{";
+            if (!v.o.empty()) {
+                if (pretty) o << "\n";
+                size_t n=0;
+                for (const auto& kv: v.o) {
+                    if (pretty) indent(o, indent_level + 2);
+                    o << "\"" << esc(kv.first) << "\":";
+                    if (pretty) o << " ";
+                    o << legacy::stringify(kv.second, pretty, indent_level + 2);
+                    if (++n < v.o.size()) o << ",";
+                    if (pretty) o << "\n";
+                }
+                if (pretty) indent(o, indent_level);
+            }
+            o << "}";
+            break;
+        }
+    }
+    return o.str();
+}
+
+} // namespace legacy
+
+// Payload plus values that exercise the number and escape paths.
+static minijson::Value sample_value() {
+    minijson::Value v = minijson::parse(benchutil::sample_payload());
+    minijson::Value extra = minijson::Value::array({});
+    const double nums[] = {0, -0.0, 1, -1, 0.1, 1.5, 1e15, 1e16, 123456789012345.0, 3.141592653589793,
+                           1e-7, 2.5e300, -4.25e-300};
+    for (double d : nums) extra.a.push_back(minijson::Value::number(d));
+    extra.a.push_back(minijson::Value::string("tab\there \"q\" back\\slash\nnl \x01 ctl"));
+    v.o["extra"] = extra;
+    return v;
+}
+
+static int check_same(const minijson::Value& v) {
+    for (bool pretty : {false, true}) {
+        std::string a = legacy::stringify(v, pretty);
+        std::string b = minijson::stringify(v, pretty);
+        if (a != b) {
+            std::fprintf(stderr, "output mismatch (pretty=%d)\nlegacy: %s\nwriter: %s\n", (int)pretty, a.c_str(), b.c_str());
+            return 1;
+        }
+        minijson::Document d = minijson::Document::parse(a);
+        if (minijson::stringify(d.root(), pretty) != a) {
+            std::fprintf(stderr, "Node output mismatch (pretty=%d)\n", (int)pretty);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int iterations = 200000;
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--iterations" && i + 1 < argc) iterations = std::atoi(argv[++i]);
+    }
+    const minijson::Value v = sample_value();
+    if (check_same(v)) return 1;
+
+    std::printf("%-8s %-16s %10s %12s %10s\n", "mode", "serializer", "MB/s", "allocs/doc", "ns/doc");
+    for (bool pretty : {false, true}) {
+        const size_t bytes = minijson::stringify(v, pretty).size();
+        auto row = [&](const char* name, auto&& fn) {
+            size_t a0 = benchutil::g_alloc.allocs;
+            auto t0 = benchutil::Clock::now();
+            size_t sink = 0;
+            for (int i=0;i<iterations;i++) sink += fn();
+            double ms = benchutil::ms_since(t0);
+            if (sink != bytes * (size_t)iterations) std::abort();
+            std::printf("%-8s %-16s %10.1f %12.1f %10.0f\n", pretty ? "pretty" : "compact", name,
+                        (double)bytes * iterations / (ms / 1000.0) / 1e6,
+                        (double)(benchutil::g_alloc.allocs - a0) / iterations, ms * 1e6 / iterations);
+        };
+        row("legacy", [&] { return legacy::stringify(v, pretty).size(); });
+        row("stringify", [&] { return minijson::stringify(v, pretty).size(); });
+        std::string buf;
+        row("Writer(reused)", [&] {
+            buf.clear();
+            minijson::Writer w(buf, pretty);
+            w.value(v);
+            return buf.size();
+        });
+    }
+    return 0;
+}
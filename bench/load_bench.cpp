@@ -0,0 +1,233 @@
+// Loopback load benchmark for asset_server: compares the epoll reactor with
+// the original single-threaded accept loop.
+//
+//   bench_load [--requests N] [--concurrency C] [--threads T] [--get] [--keepalive]
+//              [--fsync none|interval|batch] [--strict] [--batch N] [--json PATH]
+//
+// By default each request uses its own connection (Connection: close). With
+// --keepalive every client thread reuses one persistent connection; the
+// single-thread loop always closes, so it reconnects as needed. --fsync and
+// --strict set the store's sync policy for POSTs (see filestore::WriterOptions).
+// --batch N posts N records per request (NDJSON) to /api/assets/batch.
+// --json writes the table as benchutil::JsonReport results.
+#include "http_server.hpp"
+#include "http_parser.hpp"
+#include "bench_common.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int connect_local(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) { close(fd); return -1; }
+    return fd;
+}
+
+static bool wait_ready(int port) {
+    for (int i=0;i<200;i++) {
+        int fd = connect_local(port);
+        if (fd >= 0) {
+            shutdown(fd, SHUT_WR);
+            char buf[256];
+            while (recv(fd, buf, sizeof(buf), 0) > 0) {}
+            close(fd);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// Sends one request and reads until close; returns false on any failure.
+static bool one_request(int port, const std::string& req) {
+    int fd = connect_local(port);
+    if (fd < 0) return false;
+    bool ok = send(fd, req.data(), req.size(), MSG_NOSIGNAL) == (ssize_t)req.size();
+    char buf[16384];
+    ssize_t total = 0, n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) total += n;
+    close(fd);
+    return ok && total > 0;
+}
+
+// Persistent-connection variant: sends on fd (reconnecting if needed) and reads
+// exactly one response.
+static bool one_request_keepalive(int port, const std::string& req, int& fd, std::string& buf) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (fd < 0) fd = connect_local(port);
+        if (fd < 0) return false;
+        buf.clear();
+        httpparser::Parser parser(httpparser::Kind::Response);
+        auto st = httpparser::Status::Incomplete;
+        if (send(fd, req.data(), req.size(), MSG_NOSIGNAL) == (ssize_t)req.size()) {
+            char tmp[16384];
+            ssize_t n;
+            while (st == httpparser::Status::Incomplete && (n = recv(fd, tmp, sizeof(tmp), 0)) > 0) {
+                buf.append(tmp, tmp + n);
+                st = parser.parse(buf);
+            }
+        }
+        if (st == httpparser::Status::Complete) {
+            if (!parser.response().keep_alive()) { close(fd); fd = -1; }
+            return true;
+        }
+        close(fd);
+        fd = -1;
+    }
+    return false;
+}
+
+struct Result {
+    double seconds = 0;
+    size_t ok = 0, failed = 0;
+    double p50_us = 0, p99_us = 0, max_us = 0;
+};
+
+static Result drive(int port, const std::string& req, int requests, int concurrency, bool keepalive) {
+    std::vector<std::vector<double>> lat(concurrency);
+    std::atomic<int> next{0};
+    std::atomic<size_t> failed{0};
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> ts;
+    for (int c=0;c<concurrency;c++) {
+        ts.emplace_back([&, c]{
+            int fd = -1;
+            std::string buf;
+            while (next.fetch_add(1) < requests) {
+                auto s = std::chrono::steady_clock::now();
+                bool ok = keepalive ? one_request_keepalive(port, req, fd, buf) : one_request(port, req);
+                auto e = std::chrono::steady_clock::now();
+                if (!ok) { failed++; continue; }
+                lat[c].push_back(std::chrono::duration<double, std::micro>(e - s).count());
+            }
+            if (fd >= 0) close(fd);
+        });
+    }
+    for (auto& t : ts) t.join();
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::vector<double> all;
+    for (auto& v : lat) all.insert(all.end(), v.begin(), v.end());
+    std::sort(all.begin(), all.end());
+    Result r;
+    r.seconds = std::chrono::duration<double>(t1 - t0).count();
+    r.ok = all.size();
+    r.failed = failed;
+    if (!all.empty()) {
+        r.p50_us = all[all.size() / 2];
+        r.p99_us = all[std::min(all.size() - 1, all.size() * 99 / 100)];
+        r.max_us = all.back();
+    }
+    return r;
+}
+
+int main(int argc, char** argv) {
+    int requests = 20000;
+    int concurrency = 64;
+    int threads = 0;
+    bool get = false;
+    bool keepalive = false;
+    int batch = 0;
+    std::string json_path, fsync = "none";
+    filestore::WriterOptions store;
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--requests" && i + 1 < argc) requests = std::atoi(argv[++i]);
+        else if (a == "--concurrency" && i + 1 < argc) concurrency = std::atoi(argv[++i]);
+        else if (a == "--threads" && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if (a == "--get") get = true;
+        else if (a == "--keepalive") keepalive = true;
+        else if (a == "--fsync" && i + 1 < argc) {
+            fsync = argv[++i];
+            store.sync = fsync == "batch" ? filestore::SyncPolicy::Batch
+                       : fsync == "interval" ? filestore::SyncPolicy::Interval : filestore::SyncPolicy::None;
+        }
+        else if (a == "--strict") store.strict = true;
+        else if (a == "--batch" && i + 1 < argc) batch = std::atoi(argv[++i]);
+        else if (a == "--json" && i + 1 < argc) json_path = std::filesystem::absolute(argv[++i]).string();
+    }
+    if (concurrency < 1) concurrency = 1;
+    benchutil::JsonReport report("load");
+    report.config("requests", requests);
+    report.config("concurrency", concurrency);
+    report.config("threads", threads);
+    report.config("method", get ? "GET" : "POST");
+    report.config("keepalive", keepalive ? 1 : 0);
+    report.config("fsync", fsync);
+    report.config("strict", store.strict ? 1 : 0);
+    report.config("batch", batch);
+
+    // Keep data/ and logs/ out of the source tree.
+    auto dir = std::filesystem::temp_directory_path() / ("asset_bench_load_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+    std::filesystem::current_path(dir);
+
+    std::string body = benchutil::sample_payload();
+    std::string target = "/api/assets";
+    if (batch > 0) {
+        // distinct asset ids, so the index grows like a bulk import
+        const std::string one = body;
+        const size_t id = one.find("asset-deadbeef");
+        body.clear();
+        for (int i=0;i<batch;i++) {
+            char hex[16];
+            std::snprintf(hex, sizeof(hex), "%08x", (unsigned)i);
+            body += one.substr(0, id + 6) + hex + one.substr(id + 14) + "\n";
+        }
+        target = "/api/assets/batch";
+    }
+    const std::string conn = keepalive ? "" : "Connection: close\r\n";
+    std::string req = get
+        ? "GET / HTTP/1.1\r\nHost: bench\r\n" + conn + "\r\n"
+        : "POST " + target + " HTTP/1.1\r\nHost: bench\r\n" + conn + "Content-Type: application/json\r\nContent-Length: " +
+          std::to_string(body.size()) + "\r\n\r\n" + body;
+
+    struct Mode { const char* name; int port; bool single; };
+    Mode modes[] = { {"single-thread", 18931, true}, {"epoll", 18932, false} };
+
+    std::printf("%-14s %10s %10s %10s %10s %10s %8s %12s\n", "mode", "requests", "req/s", "p50(us)", "p99(us)", "max(us)", "failed",
+                "records/s");
+    for (const auto& m : modes) {
+        httpserver::Options opt;
+        opt.port = m.port;
+        opt.threads = threads;
+        opt.single_thread = m.single;
+        opt.store = store;
+        std::thread([opt]{ httpserver::run(opt); }).detach();
+        if (!wait_ready(m.port)) { std::fprintf(stderr, "server (%s) did not start\n", m.name); return 1; }
+
+        Result r = drive(m.port, req, requests, concurrency, keepalive);
+        const double records = get ? 0.0 : r.ok * (double)std::max(batch, 1) / r.seconds;
+        std::printf("%-14s %10zu %10.0f %10.1f %10.1f %10.1f %8zu %12.0f\n", m.name, r.ok,
+                    r.ok / r.seconds, r.p50_us, r.p99_us, r.max_us, r.failed, records);
+        const std::string name = m.name;
+        report.add(name + ".req_per_s", r.ok / r.seconds, "1/s");
+        report.add(name + ".p50_us", r.p50_us, "us");
+        report.add(name + ".p99_us", r.p99_us, "us");
+        report.add(name + ".max_us", r.max_us, "us");
+        report.add(name + ".failed", (double)r.failed, "requests");
+        if (!get) report.add(name + ".records_per_s", records, "1/s");
+    }
+
+    std::filesystem::current_path(dir.parent_path());
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    return report.write(json_path) ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// Cost of one log call as seen by the caller, from 1 and 16 threads: the
+// original logger (create_directories, localtime, open/append/close per
+// message) against the async ring with drop and block policies, a
+// structured record with fields, and a call below the runtime level. Each
+// mode runs in its own process, since the logger is configured once.
+//
+//   bench_log [--calls 200000] [--threads 1,16] [--mode legacy|drop|block|fields|disabled]
+#include "logger.hpp"
+#include "bench_common.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using benchutil::Clock;
+using benchutil::ms_since;
+
+// The logger as it was before the async backend.
+static void legacy_info(const std::string& path, const std::string& tag, const std::string& msg) {
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+    std::time_t t = std::time(nullptr);
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    std::string line = "[" + std::string(buf) + "][INFO][" + tag + "] " + msg;
+    std::ofstream f(path, std::ios::app);
+    f << line << "\n";
+}
+
+int main(int argc, char** argv) {
+    long calls = 200000;
+    std::string threads_arg = "1,16", mode;
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--calls" && i + 1 < argc) calls = std::atol(argv[++i]);
+        else if (a == "--threads" && i + 1 < argc) threads_arg = argv[++i];
+        else if (a == "--mode" && i + 1 < argc) mode = argv[++i];
+    }
+
+    if (mode.empty()) {
+        std::printf("%-8s %8s %12s %14s %12s %10s\n", "mode", "threads", "calls", "ns/call", "drain (ms)", "dropped");
+        std::fflush(stdout);
+        for (const char* m : {"legacy", "drop", "block", "fields", "disabled"}) {
+            std::string cmd = std::string(argv[0]) + " --mode " + m + " --calls " + std::to_string(calls) +
+                              " --threads " + threads_arg;
+            if (std::system(cmd.c_str()) != 0) return 1;
+        }
+        return 0;
+    }
+
+    auto dir = std::filesystem::temp_directory_path() / ("asset_bench_log_" + mode);
+    std::filesystem::remove_all(dir);
+    std::string path = (dir / "app.log").string();
+    if (mode != "legacy") {
+        logutil::Options opts;
+        opts.path = path;
+        opts.block_when_full = mode == "block";
+        if (mode == "disabled") opts.level = logutil::Level::Warn;
+        logutil::configure(opts);
+    }
+    const std::string msg = "POST /api/assets 201 asset_id=asset-deadbeef bytes=412";
+
+    std::vector<int> counts;
+    for (size_t p = 0; p < threads_arg.size();) {
+        size_t q = threads_arg.find(',', p);
+        if (q == std::string::npos) q = threads_arg.size();
+        counts.push_back(std::atoi(threads_arg.substr(p, q - p).c_str()));
+        p = q + 1;
+    }
+
+    for (int n : counts) {
+        if (n < 1) continue;
+        // Legacy is ~100x slower; fewer calls keep the run short.
+        const long per_thread = (mode == "legacy" ? calls / 20 : calls) / n;
+        std::atomic<long long> total_ns{0};
+        std::vector<std::thread> ts;
+        for (int t=0;t<n;t++) {
+            ts.emplace_back([&] {
+                auto t0 = Clock::now();
+                for (long i=0;i<per_thread;i++) {
+                    if (mode == "legacy") legacy_info(path, "server", msg);
+                    else if (mode == "drop" || mode == "block") logutil::info("server", msg);
+                    else LOGUTIL(Info, "server", "asset stored " + std::to_string(i),
+                                 {{"asset_id", "asset-deadbeef"}, {"position", i}});
+                }
+                total_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+            });
+        }
+        for (auto& t : ts) t.join();
+        const double ns = (double)total_ns / (double)(per_thread * n);
+        std::printf("%-8s %8d %12ld %14.0f %12s %10s\n", mode.c_str(), n, per_thread * n, ns, "-", "-");
+    }
+    if (mode != "legacy") {
+        auto t0 = Clock::now();
+        logutil::shutdown();
+        std::printf("%-8s %8s %12s %14s %12.1f %10llu\n", mode.c_str(), "", "", "", ms_since(t0),
+                    (unsigned long long)logutil::dropped());
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    return 0;
+}
@@ -0,0 +1,67 @@
+// Instrumentation cost per request, from 1 and 16 threads: the stage timers
+// and route counter an instrumented POST /api/assets goes through
+// (read_request, json_parse, validate, append, send + count_request) with
+// metrics on and switched off, plus the time of one /metrics render.
+//
+//   bench_metrics [--requests 1000000] [--threads 1,16]
+#include "metrics.hpp"
+#include "bench_common.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using benchutil::Clock;
+using benchutil::ms_since;
+
+// Keeps the loop from being folded away.
+static std::atomic<uint64_t> g_sink{0};
+
+static void one_request(uint64_t i) {
+    using metrics::Stage;
+    uint64_t work = i;
+    for (Stage s : {Stage::ReadRequest, Stage::JsonParse, Stage::Validate, Stage::Append, Stage::Send}) {
+        metrics::Timer t(s);
+        work = work * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    metrics::count_request(metrics::Route::Post, 201);
+    if (work == 42) g_sink++;
+}
+
+int main(int argc, char** argv) {
+    long requests = 1000000;
+    std::string threads_arg = "1,16";
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--requests" && i + 1 < argc) requests = std::atol(argv[++i]);
+        else if (a == "--threads" && i + 1 < argc) threads_arg = argv[++i];
+    }
+    const std::vector<long> counts = benchutil::parse_counts(threads_arg);
+
+    std::printf("%-9s %8s %12s %14s\n", "metrics", "threads", "requests", "ns/request");
+    for (bool on : {true, false}) {
+        metrics::set_enabled(on);
+        for (long n : counts) {
+            const long per_thread = requests / n;
+            std::atomic<long long> total_ns{0};
+            std::vector<std::thread> ts;
+            for (long t=0;t<n;t++) {
+                ts.emplace_back([&] {
+                    auto t0 = Clock::now();
+                    for (long i=0;i<per_thread;i++) one_request((uint64_t)i);
+                    total_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+                });
+            }
+            for (auto& t : ts) t.join();
+            std::printf("%-9s %8ld %12ld %14.1f\n", on ? "on" : "off", n, per_thread * n,
+                        (double)total_ns / (double)(per_thread * n));
+        }
+    }
+
+    auto t0 = Clock::now();
+    std::string body = metrics::render();
+    std::printf("render: %.3f ms, %zu bytes\n", ms_since(t0), body.size());
+    return 0;
+}
@@ -0,0 +1,79 @@
+// GET /api/stats aggregations over the column table vs the same
+// aggregation walking the index rows (AssetRecord per asset).
+//
+//   bench_stats [--assets 500000] [--iterations 20]
+#include "asset_index.hpp"
+#include "bench_common.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <string>
+
+// Row-wise equivalent of group_by=os&metrics=ram_total_mb,disk_free_gb.
+static size_t rows_by_os(const assetindex::AssetIndex& idx) {
+    struct Acc { size_t count = 0; double ram = 0, ram_min = 1e300, ram_max = -1e300, free = 0; };
+    std::map<std::string_view, Acc> groups;
+    for (const auto& e : idx.entries()) {
+        const auto& r = e.record;
+        Acc& a = groups[idx.strings().str(r.os)];
+        a.count++;
+        a.ram += r.ram_total_mb;
+        a.ram_min = std::min(a.ram_min, r.ram_total_mb);
+        a.ram_max = std::max(a.ram_max, r.ram_total_mb);
+        for (const auto& d : r.disks) a.free += d.free_gb;
+    }
+    return groups.size();
+}
+
+int main(int argc, char** argv) {
+    long assets = 500000;
+    int iterations = 20;
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--assets" && i + 1 < argc) assets = std::atol(argv[++i]);
+        else if (a == "--iterations" && i + 1 < argc) iterations = std::atoi(argv[++i]);
+    }
+    if (assets < 1) assets = 1;
+    if (iterations < 1) iterations = 1;
+
+    auto dir = std::filesystem::temp_directory_path() / "asset_bench_stats";
+    std::filesystem::create_directories(dir);
+    const std::string path = (dir / "assets.jsonl").string();
+    benchutil::write_store(path, assets, assets);
+
+    assetindex::AssetIndex idx;
+    auto t0 = benchutil::Clock::now();
+    idx.load(path);
+    std::printf("assets=%zu disk_rows=%zu load=%.1f ms\n", idx.size(), idx.columns().disk_rows(), benchutil::ms_since(t0));
+
+    struct Case { const char* name; assetindex::StatsQuery q; };
+    const Case cases[] = {
+        {"fleet (all metrics)", {"", {}}},
+        {"group_by=os", {"os", {"ram_total_mb", "disk_free_gb"}}},
+        {"group_by=cpu_model", {"cpu_model", {}}},
+        {"group_by=mount", {"mount", {}}},
+    };
+    std::string out, err;
+    for (const auto& c : cases) {
+        t0 = benchutil::Clock::now();
+        for (int i=0;i<iterations;i++) {
+            out.clear();
+            if (!assetindex::stats_json(idx.columns(), idx.strings(), c.q, out, err)) {
+                std::fprintf(stderr, "%s: %s\n", c.name, err.c_str());
+                return 1;
+            }
+        }
+        std::printf("%-22s %8.3f ms/query  (%zu bytes)\n", c.name, benchutil::ms_since(t0) / iterations, out.size());
+    }
+
+    size_t groups = 0;
+    t0 = benchutil::Clock::now();
+    for (int i=0;i<iterations;i++) groups += rows_by_os(idx);
+    std::printf("%-22s %8.3f ms/query  (%zu groups, row-wise baseline)\n", "rows group_by=os",
+                benchutil::ms_since(t0) / iterations, groups / iterations);
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Reading the JSONL store: filestore::read_lines (getline into a vector of
+// strings) vs filestore::MappedLines (string_views over an mmap), plus the
+// cost of picking up appended records with an incremental refresh.
+//
+//   bench_store_read [--lines 1000000] [--append 10000] [--keep]
+#include "file_store.hpp"
+#include "bench_common.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+// Peak heap bytes above the level at entry while f runs.
+template <class F>
+static long long peak_heap(F&& f) {
+    long long base = benchutil::g_alloc.live;
+    benchutil::g_alloc.peak = base;
+    f();
+    return benchutil::g_alloc.peak - base;
+}
+
+int main(int argc, char** argv) {
+    long lines = 1000000, append = 10000;
+    bool keep = false;
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--lines" && i + 1 < argc) lines = std::atol(argv[++i]);
+        else if (a == "--append" && i + 1 < argc) append = std::atol(argv[++i]);
+        else if (a == "--keep") keep = true;
+    }
+
+    auto dir = std::filesystem::temp_directory_path() / "asset_bench_store_read";
+    std::filesystem::create_directories(dir);
+    std::string path = (dir / "assets.jsonl").string();
+    benchutil::write_store(path, lines, 50000);
+    const double mb = std::filesystem::file_size(path) / 1048576.0;
+
+    // Touch every byte so both readers pay for the data, not just the index.
+    size_t sink = 0;
+    auto t0 = benchutil::Clock::now();
+    size_t n_copy = 0;
+    long long heap_copy = peak_heap([&] {
+        auto all = filestore::read_lines(path);
+        for (const auto& l : all) sink += (unsigned char)l.back();
+        n_copy = all.size();
+    });
+    double copy_ms = benchutil::ms_since(t0);
+
+    filestore::MappedLines m(path);
+    std::string err;
+    t0 = benchutil::Clock::now();
+    long long heap_map = peak_heap([&] {
+        if (!m.refresh(err)) { std::fprintf(stderr, "%s\n", err.c_str()); std::exit(1); }
+        for (size_t i=0;i<m.size();i++) sink += (unsigned char)m.line(i).back();
+    });
+    double map_ms = benchutil::ms_since(t0);
+    if (m.size() != n_copy) { std::fprintf(stderr, "line count mismatch\n"); return 1; }
+
+    benchutil::write_store(path, append, 50000, true);
+    t0 = benchutil::Clock::now();
+    if (!m.refresh(err)) { std::fprintf(stderr, "%s\n", err.c_str()); return 1; }
+    double incr_ms = benchutil::ms_since(t0);
+
+    std::printf("store: %ld lines, %.1f MB (checksum %zu)\n", lines, mb, sink);
+    std::printf("%-30s %12s %16s\n", "", "time (ms)", "peak heap (MB)");
+    std::printf("%-30s %12.1f %16.1f\n", "read_lines (getline copies)", copy_ms, heap_copy / 1048576.0);
+    std::printf("%-30s %12.1f %16.1f\n", "MappedLines (string_view)", map_ms, heap_map / 1048576.0);
+    std::printf("%-30s %12.2f %16s\n", ("refresh after +" + std::to_string(append) + " lines").c_str(), incr_ms, "-");
+    std::printf("indexed %zu lines after append\n", m.size());
+
+    if (!keep) {
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    }
+    return 0;
+}
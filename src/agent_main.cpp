@@ -2,14 +2,95 @@
 #include "mini_json.hpp"
 #include "http_client.hpp"
 #include "logger.hpp"
+#include "platform.hpp"
+#include "fleet_sim.hpp"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <filesystem>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <random>
+
+#include <algorithm>
+#include <cstdio>
+
+#ifdef _WIN32
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+#else
+  #include <signal.h>
+  #include <time.h>
+#endif
 
 static void usage() {
     std::cout << "Asset Inventory Agent (C++)\n"
               << "Usage:\n"
-              << "  asset_agent --host 127.0.0.1 --port 8080 --path /api/assets --retries 3 --timeout 2000\n";
+              << "  asset_agent --host 127.0.0.1 --port 8080 --path /api/assets --retries 3 --timeout 2000\n"
+              << "              [--state data/agent_state.json] [--full]\n"
+              << "              [--daemon --interval 300 --jitter 10 --splay 300] [--log-level info]\n"
+              << "  asset_agent --simulate 10000 --rate 500 --concurrency 32 [--duration 60] [--host ..] [--port ..]\n";
+}
+
+// Last payload the server acknowledged (without timestamp_utc) and its
+// version, kept between runs so that the next run can send a heartbeat or a
+// field-level delta to <path>/delta instead of the whole record.
+struct AgentState {
+    std::string asset_id;
+    std::string version;
+    minijson::Value payload;
+};
+
+static bool load_state(const std::string& file, AgentState& st) {
+    std::ifstream f(file, std::ios::binary);
+    if (!f) return false;
+    std::stringstream ss;
+    ss << f.rdbuf();
+    try {
+        auto v = minijson::parse(ss.str());
+        if (!v.is_object() || !v.has("asset_id") || !v.at("asset_id").is_string() ||
+            !v.has("version") || !v.at("version").is_string() ||
+            !v.has("payload") || !v.at("payload").is_object()) return false;
+        st.asset_id = v.at("asset_id").s;
+        st.version = v.at("version").s;
+        st.payload = v.at("payload");
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Written to a temporary file and renamed, so a crash leaves either the old
+// or the new state.
+static void save_state(const std::string& file, const minijson::Value& payload, const std::string& version) {
+    minijson::Value stored = payload;
+    stored.o.erase("timestamp_utc");
+    auto v = minijson::Value::object({
+        {"asset_id", payload.at("asset_id")},
+        {"version", minijson::Value::string(version)},
+        {"payload", std::move(stored)},
+    });
+    std::string tmp = file + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        f << minijson::stringify(v, false) << "\n";
+        if (!f) { logutil::warn("agent", "gagal menulis state: " + tmp); return; }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, file, ec);
+    if (ec) logutil::warn("agent", "gagal menulis state: " + file + ": " + ec.message());
+}
+
+static std::string response_version(const httpclient::Response& r) {
+    try {
+        auto v = minijson::parse(r.body);
+        if (v.is_object() && v.has("version") && v.at("version").is_string()) return v.at("version").s;
+    } catch (const std::exception&) {}
+    return "";
 }
 
 static std::string arg_val(int& i, int argc, char** argv) {
@@ -17,63 +98,286 @@ static std::string arg_val(int& i, int argc, char** argv) {
     return std::string(argv[++i]);
 }
 
+struct AgentOptions {
+    std::string path = "/api/assets";
+    int retries = 3;
+    std::string state_file = "data/agent_state.json";
+    bool force_full = false;
+};
+
+// Stop requests (SIGINT/SIGTERM, Ctrl+C) for daemon mode. On POSIX the
+// signals are blocked and taken with sigtimedwait, so a sleeping daemon
+// wakes only when its timer expires or it is asked to stop.
+static std::atomic<bool> g_stop{false};
+
+#ifdef _WIN32
+static BOOL WINAPI on_console_ctrl(DWORD) { g_stop = true; return TRUE; }
+#else
+static sigset_t g_stop_signals;
+#endif
+
+// Called first in main: threads inherit the mask, so it has to be in place
+// before anything (the logger) starts one.
+static void init_stop_signals() {
+#ifdef _WIN32
+    SetConsoleCtrlHandler(on_console_ctrl, TRUE);
+#else
+    sigemptyset(&g_stop_signals);
+    sigaddset(&g_stop_signals, SIGINT);
+    sigaddset(&g_stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &g_stop_signals, nullptr);
+#endif
+}
+
+// Modes other than the daemon never wait for a stop: give the signals their
+// default effect back in this thread (and the threads it starts later).
+static void release_stop_signals() {
+#ifdef _WIN32
+    SetConsoleCtrlHandler(on_console_ctrl, FALSE);
+#else
+    pthread_sigmask(SIG_UNBLOCK, &g_stop_signals, nullptr);
+#endif
+}
+
+// Sleeps up to ms; returns true when a stop was requested.
+static bool wait_stop(long long ms) {
+    if (g_stop) return true;
+#ifdef _WIN32
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (!g_stop && std::chrono::steady_clock::now() < until) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+#else
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    for (;;) {
+        auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(until - std::chrono::steady_clock::now()).count();
+        if (left <= 0) break;
+        struct timespec ts{};
+        ts.tv_sec = (time_t)(left / 1000000000LL);
+        ts.tv_nsec = (long)(left % 1000000000LL);
+        if (sigtimedwait(&g_stop_signals, nullptr, &ts) > 0) { g_stop = true; break; }
+    }
+#endif
+    return g_stop;
+}
+
+// Sends one report: a delta against the acknowledged state when there is
+// one, the full payload otherwise (or when the server does not accept the
+// delta). Transport errors and 5xx are retried with backoff. Returns true
+// once the server acknowledged the payload; state follows the server.
+static bool report(httpclient::Connection& conn, const AgentOptions& o, const minijson::Value& payload,
+                   AgentState& state, bool& have_state) {
+    const std::string version = inventory::payload_version(payload);
+    const bool use_delta = have_state && !o.force_full && state.asset_id == payload.at("asset_id").s;
+
+    // With an acknowledged base the agent sends a delta (a heartbeat when
+    // nothing but the timestamp changed); the server answers 409 when its
+    // latest record is not that base, and the full payload follows.
+    std::string delta_body;
+    if (use_delta) {
+        minijson::Value set;
+        std::vector<std::string> unset;
+        inventory::payload_delta(state.payload, payload, set, unset);
+        auto delta = minijson::Value::object({
+            {"asset_id", payload.at("asset_id")},
+            {"timestamp_utc", payload.at("timestamp_utc")},
+            {"base", minijson::Value::string(state.version)},
+        });
+        if (!set.o.empty()) delta.o["set"] = std::move(set);
+        if (!unset.empty()) {
+            std::vector<minijson::Value> names;
+            for (auto& u : unset) names.push_back(minijson::Value::string(std::move(u)));
+            delta.o["unset"] = minijson::Value::array(std::move(names));
+        }
+        delta_body = minijson::stringify(delta, false);
+    }
+    std::string body = minijson::stringify(payload, true);
+
+    // Only a changed version rewrites the state file.
+    auto acknowledged = [&]() {
+        if (!have_state || state.version != version || state.asset_id != payload.at("asset_id").s) {
+            save_state(o.state_file, payload, version);
+            state.asset_id = payload.at("asset_id").s;
+            state.version = version;
+            state.payload = payload;
+            state.payload.o.erase("timestamp_utc");
+            have_state = true;
+        }
+        return true;
+    };
+
+    int attempt = 0;
+    httpclient::Response last;
+    bool send_delta = use_delta;
+    while (attempt <= o.retries) {
+        last = send_delta ? conn.post_json(o.path + "/delta", delta_body) : conn.post_json(o.path, body);
+        if (send_delta && last.error.empty() && last.status >= 200 && last.status < 300 &&
+            response_version(last) == version) {
+            std::cout << "[OK] Sent asset delta (" << delta_body.size() << " bytes). HTTP " << last.status << "\n";
+            return acknowledged();
+        }
+        if (send_delta && last.error.empty() && last.status < 500) {
+            // Base unknown to the server, endpoint missing or delta refused:
+            // fall back to the full payload right away.
+            LOGUTIL(Info, "agent", "delta not applied, sending full payload", {{"status", last.status}});
+            send_delta = false;
+            continue;
+        }
+        if (!send_delta && last.status >= 200 && last.status < 300) {
+            std::cout << "[OK] Sent asset data. HTTP " << last.status << "\n";
+            return acknowledged();
+        }
+        std::string msg = "attempt " + std::to_string(attempt+1) + " failed: ";
+        if (!last.error.empty()) msg += last.error;
+        else msg += "HTTP " + std::to_string(last.status) + " body=" + last.body;
+        logutil::warn("agent", msg);
+        std::cerr << "[WARN] " << msg << "\n";
+
+        if (attempt == o.retries) break;
+        int backoff = 1 << attempt; // 1,2,4...
+        if (wait_stop(backoff * 1000LL)) break;
+        attempt++;
+    }
+    return false;
+}
+
 int main(int argc, char** argv) {
+    init_stop_signals();
     logutil::ensure_dirs();
 
     std::string host = "127.0.0.1";
     int port = 8080;
-    std::string path = "/api/assets";
-    int retries = 3;
     int timeout_ms = 2000;
     std::string agent_version = "1.0.0";
+    AgentOptions o;
+    bool daemon = false;
+    long long interval_s = 300;
+    int jitter_pct = 10;
+    long long splay_s = -1; // default: interval
+    std::string log_level = "info";
+    fleetsim::Options sim;
+    bool simulate = false;
 
     for (int i=1;i<argc;i++) {
         std::string a = argv[i];
         if (a == "--help" || a == "-h") { usage(); return 0; }
         else if (a == "--host") host = arg_val(i, argc, argv);
         else if (a == "--port") port = std::atoi(arg_val(i, argc, argv).c_str());
-        else if (a == "--path") path = arg_val(i, argc, argv);
-        else if (a == "--retries") retries = std::atoi(arg_val(i, argc, argv).c_str());
+        else if (a == "--path") o.path = arg_val(i, argc, argv);
+        else if (a == "--retries") o.retries = std::atoi(arg_val(i, argc, argv).c_str());
         else if (a == "--timeout") timeout_ms = std::atoi(arg_val(i, argc, argv).c_str());
         else if (a == "--version") agent_version = arg_val(i, argc, argv);
+        else if (a == "--state") o.state_file = arg_val(i, argc, argv);
+        else if (a == "--full") o.force_full = true;
+        else if (a == "--daemon") daemon = true;
+        else if (a == "--interval") interval_s = std::atoll(arg_val(i, argc, argv).c_str());
+        else if (a == "--jitter") jitter_pct = std::atoi(arg_val(i, argc, argv).c_str());
+        else if (a == "--splay") splay_s = std::atoll(arg_val(i, argc, argv).c_str());
+        else if (a == "--log-level") log_level = arg_val(i, argc, argv);
+        else if (a == "--simulate") { simulate = true; sim.agents = (uint64_t)std::atoll(arg_val(i, argc, argv).c_str()); }
+        else if (a == "--rate") sim.rate = std::atof(arg_val(i, argc, argv).c_str());
+        else if (a == "--concurrency") sim.concurrency = std::atoi(arg_val(i, argc, argv).c_str());
+        else if (a == "--duration") sim.duration_s = std::atof(arg_val(i, argc, argv).c_str());
     }
     if (port <= 0) port = 8080;
-    if (retries < 0) retries = 0;
+    if (o.retries < 0) o.retries = 0;
     if (timeout_ms < 200) timeout_ms = 200;
+    if (interval_s < 1) interval_s = 1;
+    if (jitter_pct < 0) jitter_pct = 0;
+    if (jitter_pct > 50) jitter_pct = 50;
+    if (splay_s < 0) splay_s = interval_s;
+    if (!daemon) release_stop_signals();
+    logutil::Options log_opt;
+    bool bad_level = !logutil::parse_level(log_level, log_opt.level);
+    logutil::configure(log_opt);
+    if (bad_level) logutil::warn("agent", "--log-level tidak valid (debug|info|warn|error|off): " + log_level);
 
-    auto payload = inventory::build_asset_payload(agent_version);
-    std::string why;
-    if (!inventory::validate_asset_schema(payload, why)) {
-        logutil::error("agent", "payload schema invalid: " + why);
-        std::cerr << "[ERROR] payload schema invalid: " << why << "\n";
-        return 1;
+    if (simulate) {
+        // Synthetic fleet: no collector, state file or retries.
+        sim.host = host;
+        sim.port = port;
+        sim.path = o.path;
+        sim.timeout_ms = timeout_ms;
+        sim.agent_version = agent_version;
+        if (sim.agents < 1) sim.agents = 1;
+        if (sim.concurrency < 1) sim.concurrency = 1;
+        if (sim.rate < 0) sim.rate = 0;
+        LOGUTIL(Info, "simulate", "started", {{"agents", sim.agents}, {"rate", sim.rate},
+                                               {"concurrency", sim.concurrency}, {"duration_s", sim.duration_s}});
+        auto r = fleetsim::run(sim);
+        if (!r.error.empty()) {
+            logutil::error("simulate", r.error);
+            std::cerr << "[ERROR] " << r.error << "\n";
+            return 1;
+        }
+        std::cout << fleetsim::summary(sim, r);
+        LOGUTIL(Info, "simulate", "finished", {{"ok", r.ok}, {"failed", r.failed}, {"seconds", r.seconds},
+                                                {"p99_us", r.latency.percentile(0.99)}});
+        return r.ok ? 0 : 1;
     }
 
-    std::string body = minijson::stringify(payload, true);
-
-    logutil::info("agent", "sending asset payload to http://" + host + ":" + std::to_string(port) + path);
+    inventory::AssetCollector collector(agent_version);
+    AgentState state;
+    bool have_state = load_state(o.state_file, state);
+    httpclient::Connection conn(host, port, timeout_ms);
 
-    int attempt = 0;
-    httpclient::Response last;
-    while (attempt <= retries) {
-        last = httpclient::post_json(host, port, path, body, timeout_ms);
-        if (last.status >= 200 && last.status < 300) {
-            std::cout << "[OK] Sent asset data. HTTP " << last.status << "\n";
-            return 0;
+    if (!daemon) {
+        auto payload = collector.collect();
+        std::string why;
+        if (!inventory::validate_asset_schema(payload, why)) {
+            logutil::error("agent", "payload schema invalid: " + why);
+            std::cerr << "[ERROR] payload schema invalid: " << why << "\n";
+            return 1;
         }
-        std::string msg = "attempt " + std::to_string(attempt+1) + " failed: ";
-        if (!last.error.empty()) msg += last.error;
-        else msg += "HTTP " + std::to_string(last.status) + " body=" + last.body;
-        logutil::warn("agent", msg);
-        std::cerr << "[WARN] " << msg << "\n";
+        LOGUTIL(Info, "agent", "sending asset payload", {{"host", host}, {"port", port}, {"path", o.path}});
+        if (report(conn, o, payload, state, have_state)) return 0;
 
-        if (attempt == retries) break;
-        int backoff = 1 << attempt; // 1,2,4...
-        std::this_thread::sleep_for(std::chrono::seconds(backoff));
-        attempt++;
+        // Do not crash the "main workflow": exit code 0 but logs warn (as requested)
+        std::cout << "[DONE] Agent finished with warnings. Check logs/app.log\n";
+        return 0;
     }
 
-    // Do not crash the "main workflow": exit code 0 but logs warn (as requested)
-    std::cout << "[DONE] Agent finished with warnings. Check logs/app.log\n";
+    // Daemon: one process, one connection (and one DNS lookup), static facts
+    // cached by the collector. The first report waits a random splay so that
+    // a fleet restarted together does not check in together; after that each
+    // cycle is interval +/- jitter%, measured from the previous start.
+    std::mt19937_64 rng(std::random_device{}() ^ std::hash<std::string>{}(platforminfo::hostname()));
+    auto uniform_ms = [&rng](long long lo, long long hi) {
+        return hi <= lo ? lo : std::uniform_int_distribution<long long>(lo, hi)(rng);
+    };
+    const long long period_ms = interval_s * 1000;
+    const long long jitter_ms = period_ms * jitter_pct / 100;
+    LOGUTIL(Info, "agent", "daemon started", {{"host", host}, {"port", port}, {"path", o.path},
+                                              {"interval_s", interval_s}, {"jitter_pct", jitter_pct}});
+
+    // Footprint line roughly once an hour (and at exit).
+    const long long usage_every = std::max(1LL, 3600 / interval_s);
+    auto log_usage = [&](long long cycles) {
+        auto u = platforminfo::process_usage();
+        LOGUTIL(Info, "agent", "usage", {{"cycles", cycles}, {"max_rss_kb", u.max_rss_kb},
+                                         {"cpu_s", u.cpu_seconds}, {"fact_reads", collector.fact_reads()}});
+    };
+
+    long long cycles = 0;
+    if (!wait_stop(uniform_ms(0, splay_s * 1000))) {
+        for (;;) {
+            auto started = std::chrono::steady_clock::now();
+            auto payload = collector.collect();
+            std::string why;
+            if (!inventory::validate_asset_schema(payload, why)) {
+                logutil::error("agent", "payload schema invalid: " + why);
+            } else {
+                report(conn, o, payload, state, have_state);
+            }
+            if (++cycles % usage_every == 0) log_usage(cycles);
+
+            long long next = period_ms + uniform_ms(-jitter_ms, jitter_ms);
+            long long spent = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - started).count();
+            if (wait_stop(std::max(0LL, next - spent))) break;
+        }
+    }
+    log_usage(cycles);
+    LOGUTIL(Info, "agent", "daemon stopped");
     return 0;
 }
@@ -0,0 +1,333 @@
+#include "asset_binary.hpp"
+#include "file_store.hpp"
+#include "inventory.hpp"
+#include <cstring>
+#include <fstream>
+
+namespace assetbin {
+
+static const char kMagic[4] = {'A','I','N','V'};
+static const size_t kHeaderSize = 8;
+enum : unsigned char { kTagString = 1, kTagRecord = 2 };
+
+// ---------------------------------------------------------------------------
+// Primitives
+
+static void put_varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) { out += (char)(v | 0x80); v >>= 7; }
+    out += (char)v;
+}
+
+static void put_f64(std::string& out, double d) {
+    uint64_t u;
+    std::memcpy(&u, &d, 8);
+    char b[8];
+    for (int i=0;i<8;i++) b[i] = (char)(u >> (8 * i));
+    out.append(b, 8);
+}
+
+static void put_str(std::string& out, std::string_view s) {
+    put_varint(out, s.size());
+    out.append(s.data(), s.size());
+}
+
+static bool get_varint(std::string_view d, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && pos < d.size(); shift += 7) {
+        unsigned char c = (unsigned char)d[pos++];
+        v |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+static bool get_f64(std::string_view d, size_t& pos, double& out) {
+    if (d.size() - pos < 8) return false;
+    uint64_t u = 0;
+    for (int i=0;i<8;i++) u |= (uint64_t)(unsigned char)d[pos + i] << (8 * i);
+    std::memcpy(&out, &u, 8);
+    pos += 8;
+    return true;
+}
+
+static bool get_str(std::string_view d, size_t& pos, std::string_view& out) {
+    uint64_t n;
+    if (!get_varint(d, pos, n) || n > d.size() - pos) return false;
+    out = d.substr(pos, (size_t)n);
+    pos += (size_t)n;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Encoder
+
+static std::string_view str(const minijson::Value& v) { return v.s; }
+static std::string_view str(const minijson::Node& v) { return v.string(); }
+static const std::vector<minijson::Value>& items(const minijson::Value& v) { return v.a; }
+static const minijson::Node& items(const minijson::Node& v) { return v; }
+
+Encoder::Encoder(std::string& out) : out_(out) {
+    out_.append(kMagic, 4);
+    out_ += (char)(kVersion & 0xff);
+    out_ += (char)(kVersion >> 8);
+    out_.append(2, '\0');
+}
+
+void Encoder::id(std::string_view s) {
+    key_.assign(s.data(), s.size());
+    auto it = dict_.find(key_);
+    if (it == dict_.end()) {
+        it = dict_.emplace(key_, (uint32_t)dict_.size()).first;
+        out_ += (char)kTagString;
+        put_str(out_, s);
+    }
+    put_varint(body_, it->second);
+}
+
+template <class V>
+void Encoder::add_impl(const V& r) {
+    body_.clear();
+    put_str(body_, str(r.at("asset_id")));
+    put_str(body_, str(r.at("hostname")));
+    id(str(r.at("os")));
+    id(str(r.at("cpu_model")));
+    put_f64(body_, r.at("cpu_cores").num);
+    put_f64(body_, r.at("ram_total_mb").num);
+    put_str(body_, str(r.at("timestamp_utc")));
+    id(str(r.at("agent_version")));
+    const auto& disks = items(r.at("disks"));
+    put_varint(body_, disks.size());
+    for (const auto& d : disks) {
+        id(str(d.at("mount")));
+        put_f64(body_, d.at("total_gb").num);
+        put_f64(body_, d.at("free_gb").num);
+    }
+    out_ += (char)kTagRecord;
+    put_varint(out_, body_.size());
+    out_ += body_;
+    records_++;
+}
+
+void Encoder::add(const minijson::Value& record) { add_impl(record); }
+void Encoder::add(const minijson::Node& record) { add_impl(record); }
+
+// ---------------------------------------------------------------------------
+// Decoder
+
+bool Decoder::open(std::string_view data, std::string& err) {
+    if (data.size() < kHeaderSize || std::memcmp(data.data(), kMagic, 4) != 0) {
+        err = "bukan file binary aset";
+        return false;
+    }
+    uint16_t version = (uint16_t)((unsigned char)data[4] | ((unsigned char)data[5] << 8));
+    if (version != kVersion) {
+        err = "versi format binary tidak didukung: " + std::to_string(version);
+        return false;
+    }
+    data_ = data;
+    pos_ = kHeaderSize;
+    dict_.clear();
+    return true;
+}
+
+// Reads one entry header at data[pos]: tag and body length. Returns false if
+// the header is incomplete; the body may still be.
+static bool entry_header(std::string_view data, size_t& pos, unsigned char& tag, uint64_t& len) {
+    if (pos >= data.size()) return false;
+    tag = (unsigned char)data[pos++];
+    return get_varint(data, pos, len);
+}
+
+static bool decode_record(std::string_view body, const std::vector<std::string_view>& dict, Record& r) {
+    size_t p = 0;
+    uint64_t n = 0;
+    auto id = [&](std::string_view& out) {
+        uint64_t i;
+        if (!get_varint(body, p, i) || i >= dict.size()) return false;
+        out = dict[(size_t)i];
+        return true;
+    };
+    bool ok = get_str(body, p, r.asset_id) && get_str(body, p, r.hostname) &&
+              id(r.os) && id(r.cpu_model) &&
+              get_f64(body, p, r.cpu_cores) && get_f64(body, p, r.ram_total_mb) &&
+              get_str(body, p, r.timestamp_utc) && id(r.agent_version) &&
+              get_varint(body, p, n) && n <= body.size();
+    if (!ok) return false;
+    r.disks.resize((size_t)n);
+    for (auto& d : r.disks) {
+        if (!(id(d.mount) && get_f64(body, p, d.total_gb) && get_f64(body, p, d.free_gb))) return false;
+    }
+    return true;
+}
+
+bool Decoder::next(Record& r, std::string& err) {
+    err.clear();
+    while (pos_ < data_.size()) {
+        unsigned char tag = 0;
+        uint64_t len = 0;
+        if (!entry_header(data_, pos_, tag, len) || len > data_.size() - pos_) { err = "entry binary terpotong"; return false; }
+        std::string_view body = data_.substr(pos_, (size_t)len);
+        pos_ += (size_t)len;
+
+        if (tag == kTagString) { dict_.push_back(body); continue; }
+        if (tag != kTagRecord) continue;
+        if (!decode_record(body, dict_, r)) { err = "record binary tidak valid"; return false; }
+        return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// FileDecoder
+
+static constexpr size_t kReadChunk = 64 * 1024;
+
+bool FileDecoder::open(const std::string& path, std::string& err) {
+    in_.open(path, std::ios::binary);
+    if (!in_) { err = "tidak bisa membuka " + path; return false; }
+    buf_.resize(kHeaderSize);
+    in_.read(&buf_[0], (std::streamsize)kHeaderSize);
+    buf_.resize((size_t)in_.gcount());
+    Decoder header;
+    if (!header.open(buf_, err)) return false;
+    buf_.clear();
+    pos_ = 0;
+    dict_text_.clear();
+    dict_.clear();
+    return true;
+}
+
+bool FileDecoder::fill_entry(std::string& err) {
+    for (;;) {
+        size_t p = pos_;
+        unsigned char tag = 0;
+        uint64_t len = 0;
+        if (entry_header(buf_, p, tag, len) && len <= buf_.size() - p) return true;
+        // Incomplete: drop the consumed prefix and read more.
+        buf_.erase(0, pos_);
+        pos_ = 0;
+        size_t have = buf_.size();
+        buf_.resize(have + kReadChunk);
+        in_.read(&buf_[have], (std::streamsize)kReadChunk);
+        buf_.resize(have + (size_t)in_.gcount());
+        if (buf_.size() == have) {
+            if (have) err = "entry binary terpotong";
+            return false;
+        }
+    }
+}
+
+bool FileDecoder::next(Record& r, std::string& err) {
+    err.clear();
+    while (fill_entry(err)) {
+        unsigned char tag = 0;
+        uint64_t len = 0;
+        if (!entry_header(buf_, pos_, tag, len)) { err = "entry binary terpotong"; return false; }
+        std::string_view body = std::string_view(buf_).substr(pos_, (size_t)len);
+        pos_ += (size_t)len;
+
+        if (tag == kTagString) {
+            dict_text_.emplace_back(body);
+            dict_.push_back(dict_text_.back());
+            continue;
+        }
+        if (tag != kTagRecord) continue;
+        if (!decode_record(body, dict_, r)) { err = "record binary tidak valid"; return false; }
+        return true;
+    }
+    return false;
+}
+
+minijson::Value Record::to_value() const {
+    using minijson::Value;
+    std::vector<Value> disk_arr;
+    for (const auto& d : disks) {
+        disk_arr.push_back(Value::object({
+            {"mount", Value::string(std::string(d.mount))},
+            {"total_gb", Value::number(d.total_gb)},
+            {"free_gb", Value::number(d.free_gb)}
+        }));
+    }
+    return Value::object({
+        {"asset_id", Value::string(std::string(asset_id))},
+        {"hostname", Value::string(std::string(hostname))},
+        {"os", Value::string(std::string(os))},
+        {"cpu_model", Value::string(std::string(cpu_model))},
+        {"cpu_cores", Value::number(cpu_cores)},
+        {"ram_total_mb", Value::number(ram_total_mb)},
+        {"disks", Value::array(std::move(disk_arr))},
+        {"timestamp_utc", Value::string(std::string(timestamp_utc))},
+        {"agent_version", Value::string(std::string(agent_version))}
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Converters
+
+// Output file written in ~1 MB pieces from a reused buffer.
+class ChunkedWriter {
+public:
+    explicit ChunkedWriter(const std::string& path) : path_(path), f_(path, std::ios::binary | std::ios::trunc) {}
+
+    std::string& buffer() { return buf_; }
+    bool ok() const { return (bool)f_; }
+
+    void maybe_flush() { if (buf_.size() >= (1 << 20)) flush(); }
+    void flush() {
+        f_.write(buf_.data(), (std::streamsize)buf_.size());
+        buf_.clear();
+    }
+    bool close(std::string& err) {
+        flush();
+        f_.close();
+        if (!f_) { err = "tidak bisa menulis " + path_; return false; }
+        return true;
+    }
+
+private:
+    std::string path_;
+    std::ofstream f_;
+    std::string buf_;
+};
+
+bool is_binary_file(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    char m[4];
+    return f.read(m, 4) && std::memcmp(m, kMagic, 4) == 0;
+}
+
+bool jsonl_to_binary(const std::string& jsonl_path, const std::string& bin_path, size_t& records, std::string& err) {
+    ChunkedWriter out(bin_path);
+    if (!out.ok()) { err = "tidak bisa menulis " + bin_path; return false; }
+    Encoder enc(out.buffer());
+    filestore::for_each_record(jsonl_path, [&](std::string_view line, uint64_t) {
+        try {
+            auto doc = minijson::Document::parse(line);
+            std::string why;
+            if (inventory::validate_asset_schema(doc.root(), why)) enc.add(doc.root());
+        } catch (...) {}
+        out.maybe_flush();
+    });
+    records = enc.records();
+    return out.close(err);
+}
+
+bool binary_to_jsonl(const std::string& bin_path, const std::string& jsonl_path, size_t& records, std::string& err) {
+    FileDecoder dec;
+    if (!dec.open(bin_path, err)) return false;
+    ChunkedWriter out(jsonl_path);
+    if (!out.ok()) { err = "tidak bisa menulis " + jsonl_path; return false; }
+    Record r;
+    records = 0;
+    while (dec.next(r, err)) {
+        minijson::Writer w(out.buffer());
+        w.value(r.to_value());
+        out.buffer() += '\n';
+        out.maybe_flush();
+        records++;
+    }
+    if (!err.empty()) return false;
+    return out.close(err);
+}
+
+} // namespace assetbin
@@ -0,0 +1,113 @@
+#pragma once
+#include <deque>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "mini_json.hpp"
+
+namespace assetbin {
+
+// Compact binary encoding of asset records (the fields produced by
+// inventory::build_asset_payload; other fields are not kept).
+//
+//   header   "AINV", u16 version, u16 flags (0)
+//   entries  u8 tag, varint body length, body
+//     tag 1  dictionary string: the body; ids count up from 0 in file order
+//     tag 2  record: str asset_id, str hostname, id os, id cpu_model,
+//            f64 cpu_cores, f64 ram_total_mb, str timestamp_utc,
+//            id agent_version, varint n, n x (id mount, f64 total_gb, f64 free_gb)
+//
+// str = varint length + bytes, id = varint dictionary id, f64 = IEEE double,
+// all little-endian. A dictionary string is written just before the first
+// record using it, so files can be produced and consumed as streams. Readers
+// skip entries with unknown tags.
+constexpr uint16_t kVersion = 1;
+
+struct Disk {
+    std::string_view mount;
+    double total_gb = 0;
+    double free_gb = 0;
+};
+
+// A decoded record; the views point into the decoded buffer.
+struct Record {
+    std::string_view asset_id, hostname, os, cpu_model, timestamp_utc, agent_version;
+    double cpu_cores = 0;
+    double ram_total_mb = 0;
+    std::vector<Disk> disks;
+
+    minijson::Value to_value() const;
+};
+
+class Encoder {
+public:
+    // Appends the file header to out; records are appended by add().
+    explicit Encoder(std::string& out);
+
+    // The record must pass inventory::validate_asset_schema.
+    void add(const minijson::Value& record);
+    void add(const minijson::Node& record);
+
+    size_t records() const { return records_; }
+    size_t dictionary_size() const { return dict_.size(); }
+
+private:
+    template <class V> void add_impl(const V& record);
+    void id(std::string_view s);
+
+    std::string& out_;
+    std::string body_; // reused per record
+    std::string key_;  // lookup scratch
+    std::unordered_map<std::string, uint32_t> dict_;
+    size_t records_ = 0;
+};
+
+class Decoder {
+public:
+    // Checks the header; data must outlive the decoder and its records.
+    bool open(std::string_view data, std::string& err);
+
+    // Decodes the next record into r. Returns false at the end of the data
+    // (err empty) or on a malformed entry (err set).
+    bool next(Record& r, std::string& err);
+
+private:
+    std::string_view data_;
+    size_t pos_ = 0;
+    std::vector<std::string_view> dict_;
+};
+
+// Decoder for a file, read through a bounded buffer: memory use is the
+// dictionary plus the largest entry, not the file size. A record's views are
+// valid until the next call to next().
+class FileDecoder {
+public:
+    bool open(const std::string& path, std::string& err);
+    bool next(Record& r, std::string& err);
+
+private:
+    // Makes buf_ hold the next whole entry at pos_; false at a clean end.
+    bool fill_entry(std::string& err);
+
+    std::ifstream in_;
+    std::string buf_;
+    size_t pos_ = 0;
+    std::deque<std::string> dict_text_; // stable storage for dict_
+    std::vector<std::string_view> dict_;
+};
+
+// True when the file starts with the binary header.
+bool is_binary_file(const std::string& path);
+
+// Converters; both stream record by record. Converts a (segmented) JSONL
+// store into a binary file; lines that do not parse or validate are skipped.
+bool jsonl_to_binary(const std::string& jsonl_path, const std::string& bin_path, size_t& records, std::string& err);
+
+// Writes one compact JSON line per record of a binary file, keys in sorted
+// order as the agent sends them.
+bool binary_to_jsonl(const std::string& bin_path, const std::string& jsonl_path, size_t& records, std::string& err);
+
+} // namespace assetbin
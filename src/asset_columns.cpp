@@ -0,0 +1,229 @@
+#include "asset_columns.hpp"
+#include "asset_index.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace assetindex {
+
+void ColumnTable::set(size_t row, const AssetRecord& r) {
+    if (row == rows()) {
+        os.push_back(0); cpu_model.push_back(0); agent_version.push_back(0);
+        cpu_cores.push_back(0); ram_total_mb.push_back(0);
+        disk_total_gb.push_back(0); disk_free_gb.push_back(0);
+        disk_count.push_back(0); disk_begin.push_back((uint32_t)disk_rows());
+    }
+    os[row] = r.os;
+    cpu_model[row] = r.cpu_model;
+    agent_version[row] = r.agent_version;
+    cpu_cores[row] = r.cpu_cores;
+    ram_total_mb[row] = r.ram_total_mb;
+
+    const uint32_t n = (uint32_t)r.disks.size();
+    if (n != disk_count[row]) {
+        // Retire the old rows and append fresh ones at the end.
+        for (uint32_t i=0;i<disk_count[row];i++) disk_mount[disk_begin[row] + i] = kDead;
+        dead_disks += disk_count[row];
+        disk_begin[row] = (uint32_t)disk_rows();
+        disk_count[row] = n;
+        disk_mount.resize(disk_rows() + n);
+        disk_total.resize(disk_mount.size());
+        disk_free.resize(disk_mount.size());
+    }
+    double total = 0, free = 0;
+    for (uint32_t i=0;i<n;i++) {
+        const auto& d = r.disks[i];
+        const uint32_t k = disk_begin[row] + i;
+        disk_mount[k] = d.mount;
+        disk_total[k] = d.total_gb;
+        disk_free[k] = d.free_gb;
+        total += d.total_gb;
+        free += d.free_gb;
+    }
+    disk_total_gb[row] = total;
+    disk_free_gb[row] = free;
+
+    if (dead_disks > 1024 && dead_disks * 2 > disk_rows()) compact_disks();
+}
+
+void ColumnTable::compact_disks() {
+    std::vector<uint32_t> mount;
+    std::vector<double> total, free;
+    mount.reserve(live_disk_rows());
+    total.reserve(live_disk_rows());
+    free.reserve(live_disk_rows());
+    for (size_t row=0; row<rows(); row++) {
+        const uint32_t b = disk_begin[row];
+        disk_begin[row] = (uint32_t)mount.size();
+        for (uint32_t i=0;i<disk_count[row];i++) {
+            mount.push_back(disk_mount[b + i]);
+            total.push_back(disk_total[b + i]);
+            free.push_back(disk_free[b + i]);
+        }
+    }
+    disk_mount.swap(mount);
+    disk_total.swap(total);
+    disk_free.swap(free);
+    dead_disks = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Aggregation
+
+namespace {
+
+struct Agg {
+    double sum = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+};
+
+// Whole-column reduction. Four independent accumulators per statistic so
+// the loop vectorises without reassociation flags.
+Agg reduce(const double* v, size_t n) {
+    double s[4] = {0, 0, 0, 0};
+    double lo[4], hi[4];
+    for (int j=0;j<4;j++) { lo[j] = std::numeric_limits<double>::infinity(); hi[j] = -lo[j]; }
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (int j=0;j<4;j++) {
+            const double x = v[i + j];
+            s[j] += x;
+            lo[j] = x < lo[j] ? x : lo[j];
+            hi[j] = x > hi[j] ? x : hi[j];
+        }
+    }
+    Agg a;
+    for (; i < n; i++) { a.sum += v[i]; a.min = std::min(a.min, v[i]); a.max = std::max(a.max, v[i]); }
+    for (int j=0;j<4;j++) { a.sum += s[j]; a.min = std::min(a.min, lo[j]); a.max = std::max(a.max, hi[j]); }
+    return a;
+}
+
+// Grouped reduction: key[i] < groups, or kDead to skip the row.
+void reduce_grouped(const uint32_t* key, const double* v, size_t n, std::vector<Agg>& out) {
+    Agg* a = out.data();
+    const size_t groups = out.size();
+    for (size_t i=0;i<n;i++) {
+        const uint32_t k = key[i];
+        if (k >= groups) continue;
+        const double x = v[i];
+        a[k].sum += x;
+        a[k].min = x < a[k].min ? x : a[k].min;
+        a[k].max = x > a[k].max ? x : a[k].max;
+    }
+}
+
+struct Metric {
+    const char* name;
+    bool disk_level;
+};
+
+const Metric kMetrics[] = {
+    {"ram_total_mb", false}, {"cpu_cores", false}, {"disk_count", false},
+    {"disk_total_gb", false}, {"disk_free_gb", false},
+    {"total_gb", true}, {"free_gb", true},
+};
+
+} // namespace
+
+bool stats_json(const ColumnTable& t, const StringPool& strings, const StatsQuery& q, std::string& out,
+                std::string& err) {
+    const std::vector<uint32_t>* key = nullptr;
+    bool disk_level = false;
+    if (q.group_by == "os") key = &t.os;
+    else if (q.group_by == "cpu_model") key = &t.cpu_model;
+    else if (q.group_by == "agent_version") key = &t.agent_version;
+    else if (q.group_by == "mount") { key = &t.disk_mount; disk_level = true; }
+    else if (!q.group_by.empty()) { err = "group_by tidak dikenal: " + q.group_by; return false; }
+
+    std::vector<const Metric*> metrics;
+    for (const auto& m : kMetrics) {
+        bool wanted = q.metrics.empty() ? m.disk_level == disk_level
+                                        : std::find(q.metrics.begin(), q.metrics.end(), m.name) != q.metrics.end();
+        if (!wanted) continue;
+        if (m.disk_level != disk_level) {
+            err = std::string("metric ") + m.name + (disk_level ? " tidak tersedia per mount" : " hanya tersedia dengan group_by=mount");
+            return false;
+        }
+        metrics.push_back(&m);
+    }
+    for (const auto& name : q.metrics) {
+        bool known = false;
+        for (const auto& m : kMetrics) known = known || name == m.name;
+        if (!known) { err = "metric tidak dikenal: " + name; return false; }
+    }
+
+    const size_t n = disk_level ? t.disk_rows() : t.rows();
+    const size_t groups = key ? strings.size() : 1;
+
+    // disk_count is an integer column; widen it once so every metric goes
+    // through the same double reductions.
+    std::vector<double> disk_count;
+    auto column = [&](const Metric* m) -> const double* {
+        std::string_view name = m->name;
+        if (name == "ram_total_mb") return t.ram_total_mb.data();
+        if (name == "cpu_cores") return t.cpu_cores.data();
+        if (name == "disk_total_gb") return t.disk_total_gb.data();
+        if (name == "disk_free_gb") return t.disk_free_gb.data();
+        if (name == "total_gb") return t.disk_total.data();
+        if (name == "free_gb") return t.disk_free.data();
+        if (disk_count.empty()) disk_count.assign(t.disk_count.begin(), t.disk_count.end());
+        return disk_count.data();
+    };
+
+    std::vector<uint64_t> count(groups, 0);
+    if (key) {
+        for (uint32_t k : *key) if (k < groups) count[k]++;
+    } else {
+        count[0] = n; // disk rows are only aggregated per mount
+    }
+
+    std::vector<std::vector<Agg>> aggs(metrics.size(), std::vector<Agg>(groups));
+    for (size_t m=0;m<metrics.size();m++) {
+        const double* v = column(metrics[m]);
+        if (key) reduce_grouped(key->data(), v, n, aggs[m]);
+        else aggs[m][0] = reduce(v, n);
+    }
+
+    std::vector<uint32_t> order;
+    for (uint32_t g=0; g<groups; g++) if (count[g] || !key) order.push_back(g);
+    if (key) {
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            if (count[a] != count[b]) return count[a] > count[b];
+            return strings.str(a) < strings.str(b);
+        });
+    }
+
+    minijson::Writer w(out);
+    w.start_object();
+    w.key("group_by");
+    if (key) w.string(q.group_by); else w.null_value();
+    w.key("assets"); w.number((double)t.rows());
+    w.key("groups");
+    w.start_array();
+    for (uint32_t g : order) {
+        w.start_object();
+        w.key("key");
+        if (key) w.string(strings.str(g)); else w.null_value();
+        w.key("count"); w.number((double)count[g]);
+        for (size_t m=0;m<metrics.size();m++) {
+            const Agg& a = aggs[m][g];
+            w.key(metrics[m]->name);
+            w.start_object();
+            w.key("sum"); w.number(a.sum);
+            if (count[g]) {
+                w.key("min"); w.number(a.min);
+                w.key("max"); w.number(a.max);
+            } else {
+                w.key("min"); w.null_value();
+                w.key("max"); w.null_value();
+            }
+            w.end_object();
+        }
+        w.end_object();
+    }
+    w.end_array();
+    w.end_object();
+    return true;
+}
+
+} // namespace assetindex
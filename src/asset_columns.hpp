@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace assetindex {
+
+struct AssetRecord;
+class StringPool;
+
+// Struct-of-arrays copy of the latest record per asset, kept in step with
+// AssetIndex (row i is entries()[i]) for aggregation queries. String fields
+// are StringPool ids. Disks live in their own rows; when an asset's disk
+// count changes its old disk rows are marked dead (mount == kDead) and
+// compacted away once they make up half of the table.
+struct ColumnTable {
+    static constexpr uint32_t kDead = 0xffffffffu;
+
+    // Asset rows.
+    std::vector<uint32_t> os, cpu_model, agent_version;
+    std::vector<double> cpu_cores, ram_total_mb;
+    std::vector<double> disk_total_gb, disk_free_gb; // sums over the asset's disks
+    std::vector<uint32_t> disk_count, disk_begin;    // its rows in the disk columns
+
+    // Disk rows.
+    std::vector<uint32_t> disk_mount;
+    std::vector<double> disk_total, disk_free;
+    size_t dead_disks = 0;
+
+    size_t rows() const { return os.size(); }
+    size_t disk_rows() const { return disk_mount.size(); }
+    size_t live_disk_rows() const { return disk_mount.size() - dead_disks; }
+
+    // Writes asset row `row`; row == rows() appends.
+    void set(size_t row, const AssetRecord& r);
+
+private:
+    void compact_disks();
+};
+
+// Parameters of GET /api/stats.
+struct StatsQuery {
+    // "" (whole fleet), "os", "cpu_model", "agent_version" or "mount".
+    std::string group_by;
+    // Columns to aggregate; empty = all for the level. Asset level:
+    // ram_total_mb, cpu_cores, disk_count, disk_total_gb, disk_free_gb.
+    // Disk level (group_by=mount): total_gb, free_gb.
+    std::vector<std::string> metrics;
+};
+
+// Renders count plus sum/min/max per metric for every non-empty group as
+// JSON, groups ordered by count (descending) then key. Returns false with err
+// set for an unknown group or metric.
+bool stats_json(const ColumnTable& t, const StringPool& strings, const StatsQuery& q, std::string& out,
+                std::string& err);
+
+} // namespace assetindex
@@ -0,0 +1,220 @@
+#include "asset_index.hpp"
+#include "file_store.hpp"
+#include "inventory.hpp"
+#include <algorithm>
+#include <charconv>
+
+namespace assetindex {
+
+const char* const kCsvHeader = "asset_id,hostname,os,cpu_model,cpu_cores,ram_total_mb,timestamp_utc,disks\n";
+
+uint32_t StringPool::intern(std::string_view s) {
+    auto it = ids_.find(s);
+    if (it != ids_.end()) return it->second;
+    strings_.emplace_back(s);
+    uint32_t id = (uint32_t)(strings_.size() - 1);
+    ids_.emplace(strings_.back(), id);
+    return id;
+}
+
+uint32_t StringPool::find(std::string_view s) const {
+    auto it = ids_.find(s);
+    return it == ids_.end() ? kNone : it->second;
+}
+
+AssetIndex::AssetIndex()
+    : by_hostname_(RowOrder{&entries_, &AssetRecord::hostname}),
+      by_timestamp_(RowOrder{&entries_, &AssetRecord::timestamp_utc}) {}
+
+size_t AssetIndex::load(const std::string& path) {
+    by_hostname_.clear();
+    by_timestamp_.clear();
+    by_id_.clear();
+    entries_.clear();
+    columns_ = ColumnTable();
+    size_t n = 0;
+    filestore::for_each_record(path, [&](std::string_view line, uint64_t off) {
+        try {
+            auto doc = minijson::Document::parse(line);
+            std::string why;
+            if (!inventory::validate_asset_schema(doc.root(), why)) return;
+            upsert(doc.root(), off);
+            n++;
+        } catch (...) {}
+    });
+    return n;
+}
+
+// Value and the compact Node representation differ in a few accessors.
+static std::string_view str(const minijson::Value& v) { return v.s; }
+static std::string_view str(const minijson::Node& v) { return v.string(); }
+static size_t fields(const minijson::Value& v) { return v.o.size(); }
+static size_t fields(const minijson::Node& v) { return v.size(); }
+static const std::vector<minijson::Value>& items(const minijson::Value& v) { return v.a; }
+static const minijson::Node& items(const minijson::Node& v) { return v; }
+static minijson::Value copy(const minijson::Value& v) { return v; }
+static minijson::Value copy(const minijson::Node& v) { return v.to_value(); }
+
+template <class V>
+AssetRecord AssetIndex::make_record(const V& v) {
+    AssetRecord r;
+    r.asset_id = str(v.at("asset_id"));
+    r.hostname = str(v.at("hostname"));
+    r.timestamp_utc = str(v.at("timestamp_utc"));
+    r.os = strings_.intern(str(v.at("os")));
+    r.cpu_model = strings_.intern(str(v.at("cpu_model")));
+    r.agent_version = strings_.intern(str(v.at("agent_version")));
+    r.cpu_cores = v.at("cpu_cores").num;
+    r.ram_total_mb = v.at("ram_total_mb").num;
+    const auto& disks = items(v.at("disks"));
+    r.disks.reserve(disks.size());
+    bool extra = fields(v) != 9;
+    for (const auto& d : disks) {
+        r.disks.push_back(DiskRecord{strings_.intern(str(d.at("mount"))), d.at("total_gb").num, d.at("free_gb").num});
+        extra = extra || fields(d) != 3;
+    }
+    if (extra) r.full = std::make_unique<minijson::Value>(copy(v));
+    return r;
+}
+
+void AssetIndex::upsert(const minijson::Node& record, uint64_t position) { upsert_impl(record, position); }
+void AssetIndex::upsert(const minijson::Value& record, uint64_t position) { upsert_impl(record, position); }
+
+template <class V>
+void AssetIndex::upsert_impl(const V& record, uint64_t position) {
+    std::string_view id = str(record.at("asset_id"));
+    auto it = by_id_.find(std::string(id));
+    if (it == by_id_.end()) {
+        by_id_.emplace(std::string(id), entries_.size());
+        entries_.push_back(Entry{make_record(record), {position}});
+        const uint32_t row = (uint32_t)(entries_.size() - 1);
+        columns_.set(row, entries_.back().record);
+        by_hostname_.insert(row);
+        by_timestamp_.insert(row);
+        return;
+    }
+    const uint32_t row = (uint32_t)it->second;
+    Entry& e = entries_[row];
+    if (position >= e.history.back()) {
+        by_hostname_.erase(row);
+        by_timestamp_.erase(row);
+        e.record = make_record(record);
+        e.history.push_back(position);
+        columns_.set(row, e.record);
+        by_hostname_.insert(row);
+        by_timestamp_.insert(row);
+        return;
+    }
+    // Concurrent POSTs may be indexed in a different order than they were
+    // appended; the line furthest into the store stays the latest.
+    e.history.insert(std::upper_bound(e.history.begin(), e.history.end(), position), position);
+}
+
+const Entry* AssetIndex::find(const std::string& asset_id) const {
+    auto it = by_id_.find(asset_id);
+    return it == by_id_.end() ? nullptr : &entries_[it->second];
+}
+
+std::string AssetIndex::to_json_array(bool pretty) const {
+    // Same text as stringify(Value::array(records), pretty) had when the
+    // index kept minijson::Value records.
+    std::string out;
+    minijson::Writer w(out, pretty);
+    w.start_array();
+    for (const auto& e : entries_) write_json(w, e.record, strings_);
+    w.end_array();
+    return out;
+}
+
+std::string AssetIndex::to_csv() const {
+    std::string out = kCsvHeader;
+    for (const auto& e : entries_) append_csv_row(out, e.record, strings_);
+    return out;
+}
+
+void write_json(minijson::Writer& w, const AssetRecord& r, const StringPool& strings) {
+    if (r.full) { w.value(*r.full); return; }
+    w.start_object();
+    w.key("agent_version"); w.string(strings.str(r.agent_version));
+    w.key("asset_id"); w.string(r.asset_id);
+    w.key("cpu_cores"); w.number(r.cpu_cores);
+    w.key("cpu_model"); w.string(strings.str(r.cpu_model));
+    w.key("disks");
+    w.start_array();
+    for (const auto& d : r.disks) {
+        w.start_object();
+        w.key("free_gb"); w.number(d.free_gb);
+        w.key("mount"); w.string(strings.str(d.mount));
+        w.key("total_gb"); w.number(d.total_gb);
+        w.end_object();
+    }
+    w.end_array();
+    w.key("hostname"); w.string(r.hostname);
+    w.key("os"); w.string(strings.str(r.os));
+    w.key("ram_total_mb"); w.number(r.ram_total_mb);
+    w.key("timestamp_utc"); w.string(r.timestamp_utc);
+    w.end_object();
+}
+
+minijson::Value to_value(const AssetRecord& r, const StringPool& strings) {
+    using minijson::Value;
+    if (r.full) return *r.full;
+    std::vector<Value> disks;
+    for (const auto& d : r.disks) {
+        disks.push_back(Value::object({
+            {"mount", Value::string(std::string(strings.str(d.mount)))},
+            {"total_gb", Value::number(d.total_gb)},
+            {"free_gb", Value::number(d.free_gb)}
+        }));
+    }
+    return Value::object({
+        {"asset_id", Value::string(r.asset_id)},
+        {"hostname", Value::string(r.hostname)},
+        {"os", Value::string(std::string(strings.str(r.os)))},
+        {"cpu_model", Value::string(std::string(strings.str(r.cpu_model)))},
+        {"cpu_cores", Value::number(r.cpu_cores)},
+        {"ram_total_mb", Value::number(r.ram_total_mb)},
+        {"disks", Value::array(std::move(disks))},
+        {"timestamp_utc", Value::string(r.timestamp_utc)},
+        {"agent_version", Value::string(std::string(strings.str(r.agent_version)))}
+    });
+}
+
+static void csv_esc(std::string& out, std::string_view s) {
+    // naive CSV escape
+    bool need = s.find(',')!=std::string_view::npos || s.find('"')!=std::string_view::npos || s.find('\n')!=std::string_view::npos;
+    if (!need) { out.append(s.data(), s.size()); return; }
+    out += '"';
+    for (char c: s) { if (c=='"') out += "\"\""; else out += c; }
+    out += '"';
+}
+
+static void append_int(std::string& out, double d) {
+    char buf[24];
+    auto r = std::to_chars(buf, buf + sizeof(buf), (long long)d);
+    out.append(buf, (size_t)(r.ptr - buf));
+}
+
+void append_csv_row(std::string& out, const AssetRecord& r, const StringPool& strings) {
+    std::string disks;
+    for (size_t i=0;i<r.disks.size(); ++i) {
+        const auto& d = r.disks[i];
+        std::string_view mount = strings.str(d.mount);
+        disks.append(mount.data(), mount.size());
+        disks += ':';
+        append_int(disks, d.total_gb);
+        disks += '/';
+        append_int(disks, d.free_gb);
+        if (i+1 < r.disks.size()) disks += " | ";
+    }
+    csv_esc(out, r.asset_id); out += ',';
+    csv_esc(out, r.hostname); out += ',';
+    csv_esc(out, strings.str(r.os)); out += ',';
+    csv_esc(out, strings.str(r.cpu_model)); out += ',';
+    append_int(out, r.cpu_cores); out += ',';
+    append_int(out, r.ram_total_mb); out += ',';
+    csv_esc(out, r.timestamp_utc); out += ',';
+    csv_esc(out, disks); out += '\n';
+}
+
+} // namespace assetindex
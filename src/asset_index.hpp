@@ -0,0 +1,134 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <deque>
+#include <memory>
+#include <set>
+#include <cstdint>
+#include "mini_json.hpp"
+#include "asset_columns.hpp"
+
+namespace assetindex {
+
+// Shared immutable strings for low-cardinality fields (os, cpu_model,
+// agent_version, disk mount). Ids are dense and never reused, so records can
+// be compared and grouped by integer; views stay valid for the pool's life.
+class StringPool {
+public:
+    static constexpr uint32_t kNone = 0xffffffffu;
+
+    uint32_t intern(std::string_view s);
+    uint32_t find(std::string_view s) const; // kNone if never interned
+    std::string_view str(uint32_t id) const { return strings_[id]; }
+    size_t size() const { return strings_.size(); }
+
+private:
+    std::deque<std::string> strings_; // stable addresses for the views below
+    std::unordered_map<std::string_view, uint32_t> ids_;
+};
+
+struct DiskRecord {
+    uint32_t mount = 0; // StringPool id
+    double total_gb = 0;
+    double free_gb = 0;
+};
+
+// A validated asset record with its repeated strings interned.
+struct AssetRecord {
+    std::string asset_id, hostname, timestamp_utc;
+    uint32_t os = 0, cpu_model = 0, agent_version = 0; // StringPool ids
+    double cpu_cores = 0;
+    double ram_total_mb = 0;
+    std::vector<DiskRecord> disks;
+    // Set only when the payload carries fields beyond the schema; it is then
+    // served verbatim so nothing the agent sent is dropped.
+    std::unique_ptr<minijson::Value> full;
+};
+
+struct Entry {
+    AssetRecord record;            // latest validated record for the asset
+    std::vector<uint64_t> history; // store positions (filestore::make_position) of its lines;
+                                   // lines since compacted away keep their old positions
+};
+
+// Orders index rows by a string field of their record, ties broken by row,
+// so RowSet iterators walk assets in field order. Transparent: a KeyProbe
+// positions a lookup at (key, row) without a row holding that key. The
+// comparator reads the live records, so a row must be erased before its key
+// field changes and re-inserted after.
+struct KeyProbe {
+    std::string_view key;
+    uint32_t row;
+};
+
+struct RowOrder {
+    using is_transparent = void;
+    const std::vector<Entry>* entries;
+    std::string AssetRecord::* field;
+
+    std::string_view key(uint32_t row) const { return (*entries)[row].record.*field; }
+    bool operator()(uint32_t a, uint32_t b) const { return less(key(a), a, key(b), b); }
+    bool operator()(uint32_t a, const KeyProbe& b) const { return less(key(a), a, b.key, b.row); }
+    bool operator()(const KeyProbe& a, uint32_t b) const { return less(a.key, a.row, key(b), b); }
+    static bool less(std::string_view ka, uint32_t ra, std::string_view kb, uint32_t rb) {
+        int c = ka.compare(kb);
+        return c < 0 || (c == 0 && ra < rb);
+    }
+};
+
+using RowSet = std::set<uint32_t, RowOrder>;
+
+// Latest-state view of the store: one entry per asset_id, in first-seen
+// order. Not synchronised; the server guards it with its store lock.
+class AssetIndex {
+public:
+    AssetIndex();
+    AssetIndex(const AssetIndex&) = delete; // the row orders point at entries_
+    AssetIndex& operator=(const AssetIndex&) = delete;
+
+    // Rebuilds the index from a (segmented) JSONL store. Lines that fail to
+    // parse or validate are skipped; returns the number of lines indexed.
+    size_t load(const std::string& path);
+
+    // Records a validated payload stored at `position` in the store.
+    // It replaces the asset's record only if no later line is indexed yet.
+    void upsert(const minijson::Node& record, uint64_t position);
+    void upsert(const minijson::Value& record, uint64_t position);
+
+    const Entry* find(const std::string& asset_id) const;
+    size_t size() const { return entries_.size(); }
+    const std::vector<Entry>& entries() const { return entries_; }
+    const StringPool& strings() const { return strings_; }
+    const ColumnTable& columns() const { return columns_; }
+    const RowSet& by_hostname() const { return by_hostname_; }
+    const RowSet& by_timestamp() const { return by_timestamp_; }
+
+    // Same shapes as the historical /api/assets and /export.csv bodies,
+    // but with one row per asset.
+    std::string to_json_array(bool pretty) const;
+    std::string to_csv() const;
+
+private:
+    template <class V> AssetRecord make_record(const V& v);
+    template <class V> void upsert_impl(const V& record, uint64_t position);
+
+    StringPool strings_;
+    std::unordered_map<std::string, size_t> by_id_;
+    std::vector<Entry> entries_;
+    ColumnTable columns_;
+    RowSet by_hostname_, by_timestamp_;
+};
+
+// The record as a JSON object, keys sorted as in stringify(Value).
+void write_json(minijson::Writer& w, const AssetRecord& r, const StringPool& strings);
+
+// The record as a minijson::Value (what the agent sent).
+minijson::Value to_value(const AssetRecord& r, const StringPool& strings);
+
+// Appends one CSV row (with trailing newline).
+void append_csv_row(std::string& out, const AssetRecord& r, const StringPool& strings);
+extern const char* const kCsvHeader;
+
+} // namespace assetindex
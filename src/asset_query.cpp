@@ -0,0 +1,201 @@
+#include "asset_query.hpp"
+#include "asset_index.hpp"
+#include <algorithm>
+#include <charconv>
+
+namespace assetindex {
+
+namespace {
+
+enum : uint32_t {
+    kAgentVersion = 1u << 0, kAssetId = 1u << 1, kCpuCores = 1u << 2, kCpuModel = 1u << 3, kDisks = 1u << 4,
+    kHostname = 1u << 5, kOs = 1u << 6, kRamTotalMb = 1u << 7, kTimestampUtc = 1u << 8,
+};
+
+const struct { const char* name; uint32_t bit; } kFields[] = {
+    {"agent_version", kAgentVersion}, {"asset_id", kAssetId}, {"cpu_cores", kCpuCores},
+    {"cpu_model", kCpuModel}, {"disks", kDisks}, {"hostname", kHostname}, {"os", kOs},
+    {"ram_total_mb", kRamTotalMb}, {"timestamp_utc", kTimestampUtc},
+};
+
+// write_json restricted to the fields in mask, same key order.
+void write_projected(minijson::Writer& w, const AssetRecord& r, const StringPool& strings, uint32_t mask) {
+    w.start_object();
+    if (mask & kAgentVersion) { w.key("agent_version"); w.string(strings.str(r.agent_version)); }
+    if (mask & kAssetId) { w.key("asset_id"); w.string(r.asset_id); }
+    if (mask & kCpuCores) { w.key("cpu_cores"); w.number(r.cpu_cores); }
+    if (mask & kCpuModel) { w.key("cpu_model"); w.string(strings.str(r.cpu_model)); }
+    if (mask & kDisks) {
+        w.key("disks");
+        w.start_array();
+        for (const auto& d : r.disks) {
+            w.start_object();
+            w.key("free_gb"); w.number(d.free_gb);
+            w.key("mount"); w.string(strings.str(d.mount));
+            w.key("total_gb"); w.number(d.total_gb);
+            w.end_object();
+        }
+        w.end_array();
+    }
+    if (mask & kHostname) { w.key("hostname"); w.string(r.hostname); }
+    if (mask & kOs) { w.key("os"); w.string(strings.str(r.os)); }
+    if (mask & kRamTotalMb) { w.key("ram_total_mb"); w.number(r.ram_total_mb); }
+    if (mask & kTimestampUtc) { w.key("timestamp_utc"); w.string(r.timestamp_utc); }
+    w.end_object();
+}
+
+// Cursors are "<row>" in first-seen order and "<row>.<hex key>" in keyed
+// orders, so a page continues after the last row sent even if that row has
+// since been updated and moved.
+std::string make_cursor(uint32_t row, std::string_view key, bool keyed) {
+    static const char* hex = "0123456789abcdef";
+    std::string c = std::to_string(row);
+    if (!keyed) return c;
+    c += '.';
+    for (unsigned char ch : key) { c += hex[ch >> 4]; c += hex[ch & 15]; }
+    return c;
+}
+
+bool parse_cursor(std::string_view c, bool keyed, uint32_t& row, std::string& key) {
+    auto r = std::from_chars(c.data(), c.data() + c.size(), row);
+    if (r.ec != std::errc() || r.ptr == c.data()) return false;
+    std::string_view rest = c.substr((size_t)(r.ptr - c.data()));
+    if (!keyed) return rest.empty();
+    if (rest.empty() || rest[0] != '.' || rest.size() % 2 != 1) return false;
+    auto nibble = [](char h) {
+        return h >= '0' && h <= '9' ? h - '0' : h >= 'a' && h <= 'f' ? h - 'a' + 10 : -1;
+    };
+    key.clear();
+    for (size_t i=1;i<rest.size();i+=2) {
+        int hi = nibble(rest[i]), lo = nibble(rest[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        key += (char)(hi * 16 + lo);
+    }
+    return true;
+}
+
+// Smallest string greater than every string starting with p; "" when none.
+std::string prefix_end(std::string p) {
+    while (!p.empty()) {
+        if ((unsigned char)p.back() != 0xff) { p.back() = (char)(p.back() + 1); return p; }
+        p.pop_back();
+    }
+    return p;
+}
+
+} // namespace
+
+bool query_json(const AssetIndex& idx, const AssetQuery& q, std::string& out, std::string& err) {
+    uint32_t mask = 0;
+    for (const auto& f : q.fields) {
+        auto it = std::find_if(std::begin(kFields), std::end(kFields), [&](const auto& k) { return f == k.name; });
+        if (it == std::end(kFields)) { err = "field tidak dikenal: " + f; return false; }
+        mask |= it->bit;
+    }
+
+    const bool desc = !q.sort.empty() && q.sort[0] == '-';
+    const std::string_view sort_key = desc ? std::string_view(q.sort).substr(1) : std::string_view(q.sort);
+    const RowSet* order = nullptr;
+    std::string lo, hi; // bounds on the sort key implied by the filters
+    if (sort_key == "hostname") {
+        order = &idx.by_hostname();
+        lo = q.hostname_prefix;
+        hi = prefix_end(q.hostname_prefix);
+    } else if (sort_key == "timestamp_utc") {
+        order = &idx.by_timestamp();
+        lo = q.since;
+        hi = q.until;
+    } else if (!q.sort.empty()) {
+        err = "sort tidak dikenal: " + q.sort;
+        return false;
+    }
+
+    uint32_t cursor_row = 0;
+    std::string cursor_key;
+    const bool has_cursor = !q.cursor.empty();
+    if (has_cursor && !parse_cursor(q.cursor, order != nullptr, cursor_row, cursor_key)) {
+        err = "cursor tidak valid";
+        return false;
+    }
+
+    const auto& entries = idx.entries();
+    const auto& cols = idx.columns();
+    const uint32_t os = q.os.empty() ? StringPool::kNone : idx.strings().find(q.os);
+    const bool no_match = !q.os.empty() && os == StringPool::kNone;
+    auto matches = [&](uint32_t row) {
+        const AssetRecord& r = entries[row].record;
+        if (!q.os.empty() && cols.os[row] != os) return false;
+        if (r.hostname.compare(0, q.hostname_prefix.size(), q.hostname_prefix) != 0) return false;
+        if (!q.since.empty() && r.timestamp_utc < q.since) return false;
+        if (!q.until.empty() && r.timestamp_utc >= q.until) return false;
+        if (q.low_disk_gb >= 0) {
+            const uint32_t b = cols.disk_begin[row], n = cols.disk_count[row];
+            bool low = false;
+            for (uint32_t i=0;i<n;i++) low = low || cols.disk_free[b + i] < q.low_disk_gb;
+            if (!low) return false;
+        }
+        return true;
+    };
+
+    // One row past the page tells whether there is a next page.
+    const size_t limit = std::min(std::max<size_t>(q.limit, 1), kMaxQueryLimit);
+    std::vector<uint32_t> page;
+    auto visit = [&](uint32_t row) {
+        if (matches(row)) page.push_back(row);
+        return page.size() <= limit;
+    };
+
+    if (no_match) {
+        // os never seen: nothing to walk
+    } else if (!order) {
+        for (uint32_t row = has_cursor ? cursor_row + 1 : 0; row < entries.size(); row++) {
+            if (!visit(row)) break;
+        }
+    } else if (!desc) {
+        const auto& cmp = order->key_comp();
+        auto it = order->lower_bound(KeyProbe{lo, 0});
+        if (has_cursor) {
+            auto after = order->upper_bound(KeyProbe{cursor_key, cursor_row});
+            if (it != order->end() && (after == order->end() || cmp(*it, *after))) it = after;
+        }
+        for (; it != order->end(); ++it) {
+            if (!hi.empty() && cmp.key(*it) >= hi) break;
+            if (!visit(*it)) break;
+        }
+    } else {
+        const auto& cmp = order->key_comp();
+        auto it = hi.empty() ? order->end() : order->lower_bound(KeyProbe{hi, 0});
+        if (has_cursor) {
+            auto before = order->lower_bound(KeyProbe{cursor_key, cursor_row});
+            if (before != order->end() && (it == order->end() || cmp(*before, *it))) it = before;
+        }
+        while (it != order->begin()) {
+            --it;
+            if (cmp.key(*it) < lo) break;
+            if (!visit(*it)) break;
+        }
+    }
+
+    minijson::Writer w(out);
+    w.start_object();
+    w.key("items");
+    w.start_array();
+    const size_t n = std::min(page.size(), limit);
+    for (size_t i=0;i<n;i++) {
+        const AssetRecord& r = entries[page[i]].record;
+        if (mask) write_projected(w, r, idx.strings(), mask);
+        else write_json(w, r, idx.strings());
+    }
+    w.end_array();
+    w.key("next_cursor");
+    if (page.size() > limit) {
+        const uint32_t last = page[limit - 1];
+        w.string(make_cursor(last, order ? order->key_comp().key(last) : std::string_view(), order != nullptr));
+    } else {
+        w.null_value();
+    }
+    w.end_object();
+    return true;
+}
+
+} // namespace assetindex
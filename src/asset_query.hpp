@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace assetindex {
+
+class AssetIndex;
+
+// Parameters of GET /api/assets?... (one page of latest records).
+struct AssetQuery {
+    std::string hostname_prefix;
+    std::string os;                 // exact match; empty = any
+    std::string since, until;       // timestamp_utc in [since, until), compared as text
+    double low_disk_gb = -1;        // some disk has free_gb below this; < 0 = off
+    std::vector<std::string> fields; // projection (top-level keys); empty = whole record
+    // "" (first-seen order), "hostname" or "timestamp_utc", '-' prefix for
+    // descending; the keyed orders walk the index's RowSets.
+    std::string sort;
+    size_t limit = 100;
+    std::string cursor;             // next_cursor of the previous page
+};
+
+constexpr size_t kMaxQueryLimit = 1000;
+
+// Renders {"items":[...],"next_cursor":"..."|null}. Filters on the sort key
+// bound the walk; the others are checked per row, and the walk stops once
+// the page is full. Returns false with err set for an unknown sort or field,
+// or a cursor that does not belong to the sort.
+bool query_json(const AssetIndex& idx, const AssetQuery& q, std::string& out, std::string& err);
+
+} // namespace assetindex
@@ -1,11 +1,34 @@
 #include "file_store.hpp"
 #include <fstream>
 #include <filesystem>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <cstring>
+#ifdef _WIN32
+  #include <io.h>
+  #include <windows.h>
+#else
+  #include <unistd.h>
+  #include <sys/uio.h>
+  #include <sys/mman.h>
+  #include <climits>
+  #include <cerrno>
+#endif
 
 namespace filestore {
 
-bool append_line(const std::string& path, const std::string& line, std::string& err) {
+bool append_line(const std::string& path, const std::string& line, std::string& err, uint64_t* offset) {
     try { std::filesystem::create_directories(std::filesystem::path(path).parent_path()); } catch (...) {}
+    if (offset) {
+        std::error_code ec;
+        auto sz = std::filesystem::file_size(path, ec);
+        *offset = ec ? 0 : (uint64_t)sz;
+    }
     std::ofstream f(path, std::ios::app);
     if (!f) { err = "tidak bisa membuka file store"; return false; }
     f << line << "\n";
@@ -23,4 +46,663 @@ std::vector<std::string> read_lines(const std::string& path) {
     return out;
 }
 
+void for_each_line(const std::string& path, const std::function<void(std::string_view, uint64_t)>& fn) {
+    MappedLines m(path);
+    std::string err;
+    if (!m.refresh(err)) return;
+    for (size_t i=0;i<m.size();i++) fn(m.line(i), m.offset(i));
+    std::string_view t = m.tail();
+    if (!t.empty() && t.back() == '\r') t.remove_suffix(1);
+    if (!t.empty()) fn(t, m.mapped_bytes() - m.tail().size());
+}
+
+// ---------------------------------------------------------------------------
+// MappedLines
+
+MappedLines::MappedLines(std::string path) : path_(std::move(path)) {}
+
+MappedLines::~MappedLines() { unmap(); }
+
+void MappedLines::unmap() {
+    if (data_) {
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+#else
+        munmap((void*)data_, mapped_);
+#endif
+    }
+    data_ = nullptr;
+    mapped_ = 0;
+}
+
+bool MappedLines::refresh(std::string& err) {
+    uint64_t size = 0, id[2] = {0, 0};
+#ifdef _WIN32
+    HANDLE f = CreateFileA(path_.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) {
+        if (GetLastError() == ERROR_FILE_NOT_FOUND || GetLastError() == ERROR_PATH_NOT_FOUND) { unmap(); lines_.clear(); scanned_ = 0; return true; }
+        err = "tidak bisa membuka file store";
+        return false;
+    }
+    BY_HANDLE_FILE_INFORMATION info{};
+    GetFileInformationByHandle(f, &info);
+    size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+    id[0] = info.dwVolumeSerialNumber;
+    id[1] = ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+#else
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) { unmap(); lines_.clear(); scanned_ = 0; return true; }
+        err = "tidak bisa membuka file store";
+        return false;
+    }
+    struct stat st{};
+    fstat(fd, &st);
+    size = (uint64_t)st.st_size;
+    id[0] = (uint64_t)st.st_dev;
+    id[1] = (uint64_t)st.st_ino;
+#endif
+
+    if (size < mapped_ || id[0] != file_id_[0] || id[1] != file_id_[1]) {
+        unmap();
+        lines_.clear();
+        scanned_ = 0;
+    }
+    file_id_[0] = id[0];
+    file_id_[1] = id[1];
+
+    bool ok = true;
+    if (size > mapped_) {
+#ifdef _WIN32
+        HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const char* p = m ? (const char*)MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (m) CloseHandle(m);
+#else
+        void* v = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        const char* p = v == MAP_FAILED ? nullptr : (const char*)v;
+        if (p && scanned_ == 0) madvise(v, size, MADV_SEQUENTIAL);
+#endif
+        if (p) {
+            unmap();
+            data_ = p;
+            mapped_ = (size_t)size;
+        } else {
+            err = "mmap file store gagal";
+            ok = false;
+        }
+    }
+#ifdef _WIN32
+    CloseHandle(f);
+#else
+    ::close(fd);
+#endif
+    if (!ok) return false;
+
+    // Index complete lines past the previous scan position.
+    size_t pos = scanned_;
+    while (pos < mapped_) {
+        const char* nl = (const char*)std::memchr(data_ + pos, '\n', mapped_ - pos);
+        if (!nl) break;
+        size_t end = (size_t)(nl - data_);
+        size_t len = end - pos;
+        if (len && data_[end - 1] == '\r') len--;
+        if (len) lines_.push_back(Span{pos, (uint32_t)len});
+        pos = end + 1;
+    }
+    scanned_ = pos;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Segmented store
+
+namespace fs = std::filesystem;
+
+static std::string segment_path(const std::string& path, Segment::Kind kind, uint64_t seq) {
+    if (kind == Segment::Kind::Active) return path;
+    fs::path p(path);
+    char num[32];
+    std::snprintf(num, sizeof(num), "%08llu", (unsigned long long)seq);
+    std::string name = p.stem().string() + (kind == Segment::Kind::Snapshot ? ".snapshot." : ".") + num +
+                       p.extension().string();
+    return (p.parent_path() / name).string();
+}
+
+// Makes a rename in the store's directory durable (no-op on Windows).
+static void sync_dir(const std::string& path) {
+#ifndef _WIN32
+    std::string dir = fs::path(path).parent_path().string();
+    int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) { fsync(fd); ::close(fd); }
+#else
+    (void)path;
+#endif
+}
+
+struct StoreFiles {
+    std::vector<Segment> snapshots; // ascending seq
+    std::vector<Segment> sealed;    // ascending seq
+    std::vector<std::string> temporaries;
+};
+
+static bool parse_seq(std::string_view s, uint64_t& seq) {
+    if (s.empty()) return false;
+    seq = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        seq = seq * 10 + (uint64_t)(c - '0');
+    }
+    return true;
+}
+
+static StoreFiles scan_store(const std::string& path) {
+    StoreFiles out;
+    fs::path p(path);
+    const std::string stem = p.stem().string() + ".";
+    const std::string ext = p.extension().string();
+    std::error_code ec;
+    fs::path dir = p.parent_path().empty() ? fs::path(".") : p.parent_path();
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.compare(0, stem.size(), stem) != 0) continue;
+        std::string_view rest = std::string_view(name).substr(stem.size());
+        if (rest.size() > 4 && rest.substr(rest.size() - 4) == ".tmp") {
+            out.temporaries.push_back(it->path().string());
+            continue;
+        }
+        if (rest.size() <= ext.size() || rest.substr(rest.size() - ext.size()) != ext) continue;
+        rest.remove_suffix(ext.size());
+        Segment seg{Segment::Kind::Sealed, 0, it->path().string()};
+        if (rest.compare(0, 9, "snapshot.") == 0) {
+            seg.kind = Segment::Kind::Snapshot;
+            rest.remove_prefix(9);
+        }
+        if (!parse_seq(rest, seg.seq)) continue;
+        (seg.kind == Segment::Kind::Snapshot ? out.snapshots : out.sealed).push_back(std::move(seg));
+    }
+    auto by_seq = [](const Segment& a, const Segment& b) { return a.seq < b.seq; };
+    std::sort(out.snapshots.begin(), out.snapshots.end(), by_seq);
+    std::sort(out.sealed.begin(), out.sealed.end(), by_seq);
+    return out;
+}
+
+std::vector<Segment> list_segments(const std::string& path) {
+    StoreFiles f = scan_store(path);
+    std::vector<Segment> out;
+    uint64_t next = 0;
+    if (!f.snapshots.empty()) {
+        out.push_back(f.snapshots.back());
+        next = f.snapshots.back().seq + 1;
+    }
+    for (auto& seg : f.sealed) {
+        if (seg.seq < next) continue; // already in the snapshot
+        next = seg.seq + 1;
+        out.push_back(std::move(seg));
+    }
+    out.push_back(Segment{Segment::Kind::Active, next, path});
+    return out;
+}
+
+void remove_stale_segments(const std::string& path) {
+    StoreFiles f = scan_store(path);
+    std::error_code ec;
+    for (const auto& t : f.temporaries) fs::remove(t, ec);
+    if (f.snapshots.empty()) return;
+    const uint64_t covered = f.snapshots.back().seq;
+    for (size_t i=0;i+1<f.snapshots.size();i++) fs::remove(f.snapshots[i].path, ec);
+    for (const auto& seg : f.sealed) {
+        if (seg.seq <= covered) fs::remove(seg.path, ec);
+    }
+}
+
+void for_each_record(const std::string& path, const std::function<void(std::string_view, uint64_t)>& fn) {
+    for (const auto& seg : list_segments(path)) {
+        for_each_line(seg.path, [&](std::string_view line, uint64_t off) { fn(line, make_position(seg.seq, off)); });
+    }
+}
+
+static bool write_all(int fd, const char* p, size_t n) {
+    while (n) {
+#ifdef _WIN32
+        int w = _write(fd, p, (unsigned)(n > (1u << 30) ? (1u << 30) : n));
+#else
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+#endif
+        if (w <= 0) return false;
+        p += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+bool compact(const std::string& path, const CompactKeyFn& key, CompactStats& stats, std::string& err) {
+    stats = CompactStats{};
+    std::vector<Segment> inputs = list_segments(path);
+    inputs.pop_back(); // the active segment stays as it is
+    if (inputs.empty() || inputs.back().kind == Segment::Kind::Snapshot) return true;
+
+    // Map every input and remember, per key, its last line.
+    std::vector<std::unique_ptr<MappedLines>> files;
+    struct Ref { uint32_t file; uint32_t line; };
+    std::vector<Ref> refs;
+    std::vector<char> keep;
+    std::unordered_map<std::string, size_t> last;
+    std::string k;
+    for (const auto& seg : inputs) {
+        files.push_back(std::make_unique<MappedLines>(seg.path));
+        MappedLines& m = *files.back();
+        if (!m.refresh(err)) return false;
+        stats.bytes_in += m.mapped_bytes();
+        for (size_t i=0;i<m.size();i++) {
+            stats.lines_in++;
+            k.clear();
+            if (!key(m.line(i), k)) continue;
+            auto [it, fresh] = last.try_emplace(k, refs.size());
+            if (!fresh) { keep[it->second] = 0; it->second = refs.size(); }
+            refs.push_back(Ref{(uint32_t)(files.size() - 1), (uint32_t)i});
+            keep.push_back(1);
+        }
+    }
+
+    const uint64_t seq = inputs.back().seq;
+    const std::string final_path = segment_path(path, Segment::Kind::Snapshot, seq);
+    const std::string tmp_path = final_path + ".tmp";
+#ifdef _WIN32
+    int fd = _open(tmp_path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+    if (fd < 0) { err = "tidak bisa membuat snapshot"; return false; }
+
+    std::string buf;
+    buf.reserve(1 << 20);
+    bool ok = true;
+    for (size_t i=0;i<refs.size() && ok;i++) {
+        if (!keep[i]) continue;
+        std::string_view line = files[refs[i].file]->line(refs[i].line);
+        buf.append(line.data(), line.size());
+        buf += '\n';
+        stats.lines_out++;
+        if (buf.size() >= (1 << 20)) { ok = write_all(fd, buf.data(), buf.size()); stats.bytes_out += buf.size(); buf.clear(); }
+    }
+    if (ok && !buf.empty()) { ok = write_all(fd, buf.data(), buf.size()); stats.bytes_out += buf.size(); }
+#ifdef _WIN32
+    ok = ok && _commit(fd) == 0;
+    _close(fd);
+#else
+    ok = ok && fsync(fd) == 0;
+    ::close(fd);
+#endif
+    files.clear(); // unmap before the inputs are removed (required on Windows)
+
+    std::error_code ec;
+    if (ok) fs::rename(tmp_path, final_path, ec);
+    if (!ok || ec) {
+        fs::remove(tmp_path, ec);
+        err = "gagal menulis snapshot";
+        return false;
+    }
+    sync_dir(path);
+
+    // The new snapshot is in place; the inputs are now stale.
+    for (const auto& seg : inputs) fs::remove(seg.path, ec);
+    stats.segments = inputs.size();
+    stats.seq = seq;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// AppendWriter
+
+AppendWriter::AppendWriter(std::string path, WriterOptions opt)
+    : path_(std::move(path)), opt_(opt) {
+    if (opt_.sync_interval_ms <= 0) opt_.sync_interval_ms = 1;
+}
+
+AppendWriter::~AppendWriter() { close(); }
+
+bool AppendWriter::open(std::string& err) {
+    if (fd_ >= 0) return true;
+    try { std::filesystem::create_directories(std::filesystem::path(path_).parent_path()); } catch (...) {}
+    remove_stale_segments(path_);
+    seq_ = list_segments(path_).back().seq;
+    if (!open_active(err)) return false;
+    stop_ = false;
+    thread_ = std::thread([this]{ run(); });
+    return true;
+}
+
+bool AppendWriter::open_active(std::string& err) {
+#ifdef _WIN32
+    fd_ = _open(path_.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+    struct _stat64 st{};
+    if (fd_ >= 0 && _fstat64(fd_, &st) == 0) end_ = (uint64_t)st.st_size;
+#else
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    struct stat st{};
+    if (fd_ >= 0 && fstat(fd_, &st) == 0) end_ = (uint64_t)st.st_size;
+#endif
+    if (fd_ < 0) { err = "tidak bisa membuka file store"; return false; }
+    opened_at_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+void AppendWriter::close_active() {
+#ifdef _WIN32
+    _close(fd_);
+#else
+    ::close(fd_);
+#endif
+    fd_ = -1;
+}
+
+void AppendWriter::close() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stop_ = true;
+    }
+    work_cv_.notify_one();
+    thread_.join();
+    if (fd_ >= 0) close_active();
+}
+
+bool AppendWriter::roll_due() const {
+    if (end_ == 0) return false;
+    if (opt_.segment_bytes && end_ >= opt_.segment_bytes) return true;
+    return opt_.segment_seconds > 0 &&
+           std::chrono::steady_clock::now() - opened_at_ >= std::chrono::seconds(opt_.segment_seconds);
+}
+
+// Seals the active segment under its seq and starts a new, empty one. Called
+// by the writer thread holding lk, between batches.
+void AppendWriter::roll_locked(std::unique_lock<std::mutex>& lk) {
+    if (opt_.sync != SyncPolicy::None && durable_seq_ < written_seq_) sync_locked(lk);
+    std::string sealed = segment_path(path_, Segment::Kind::Sealed, seq_);
+    close_active();
+    std::error_code ec;
+    std::filesystem::rename(path_, sealed, ec);
+    if (!ec) {
+        sync_dir(path_);
+        seq_++;
+        rollovers_++;
+    }
+    // On failure keep appending to the same file.
+    std::string err;
+    open_active(err);
+}
+
+uint64_t AppendWriter::batches() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return written_seq_;
+}
+
+uint64_t AppendWriter::syncs() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return syncs_;
+}
+
+uint64_t AppendWriter::rollovers() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return rollovers_;
+}
+
+void AppendWriter::append_async(const std::vector<std::string>& lines, AppendDone done) {
+    auto p = std::make_unique<Pending>();
+    size_t total = 0;
+    for (const auto& l : lines) total += l.size() + 1;
+    p->data.reserve(total);
+    p->ends.reserve(lines.size());
+    for (const auto& l : lines) {
+        p->data += l;
+        p->data += '\n';
+        p->ends.push_back(p->data.size());
+    }
+    p->done = std::move(done);
+    std::unique_lock<std::mutex> lk(mu_);
+    if (fd_ < 0 || stop_ || p->ends.empty()) {
+        lk.unlock();
+        AppendResult r;
+        if (!p->ends.empty()) r.error = "file store belum dibuka";
+        p->done(std::move(r));
+        return;
+    }
+    queue_.push_back(std::move(p));
+    work_cv_.notify_one();
+}
+
+namespace {
+// Hands an AppendResult from the writer thread to a blocked caller.
+struct Waiter {
+    std::mutex mu;
+    std::condition_variable cv;
+    bool done = false;
+    AppendResult result;
+
+    AppendDone callback() {
+        return [this](AppendResult&& r) {
+            std::lock_guard<std::mutex> lk(mu);
+            result = std::move(r);
+            done = true;
+            cv.notify_one();
+        };
+    }
+    AppendResult wait() {
+        std::unique_lock<std::mutex> lk(mu);
+        cv.wait(lk, [this]{ return done; });
+        return std::move(result);
+    }
+};
+} // namespace
+
+bool AppendWriter::append(std::string line, std::string& err, uint64_t* position) {
+    std::vector<std::string> lines;
+    lines.push_back(std::move(line));
+    Waiter w;
+    append_async(lines, w.callback());
+    AppendResult r = w.wait();
+    if (!r.error.empty()) { err = r.error; return false; }
+    if (position) *position = r.positions[0];
+    return true;
+}
+
+bool AppendWriter::append_many(const std::vector<std::string>& lines, std::string& err,
+                               std::vector<uint64_t>* positions) {
+    Waiter w;
+    append_async(lines, w.callback());
+    AppendResult r = w.wait();
+    if (positions) *positions = std::move(r.positions);
+    if (!r.error.empty()) { err = r.error; return false; }
+    return true;
+}
+
+// Writes every record of the batch at the end of the file, in queue order,
+// and fills in each record's result. A failed write keeps the complete lines
+// before it and truncates the file back to the end of the last one.
+void AppendWriter::write_batch(PendingList& batch) {
+    const uint64_t start = end_;
+    uint64_t total = 0;
+    for (auto& p : batch) {
+        p->offset = start + total;
+        total += p->data.size();
+    }
+    size_t written = 0; // bytes of the batch on disk
+#ifdef _WIN32
+    std::string all;
+    for (auto& p : batch) all += p->data;
+    while (written < all.size()) {
+        int n = _write(fd_, all.data() + written, (unsigned)(all.size() - written));
+        if (n <= 0) break;
+        written += (size_t)n;
+    }
+#else
+    size_t i = 0, skip = 0; // next record, bytes of it already written
+    while (i < batch.size()) {
+        iovec iov[IOV_MAX < 1024 ? IOV_MAX : 1024];
+        int cnt = 0;
+        for (size_t j=i; j<batch.size() && cnt < (int)(sizeof(iov)/sizeof(iov[0])); j++, cnt++) {
+            size_t s = j == i ? skip : 0;
+            iov[cnt].iov_base = (char*)batch[j]->data.data() + s;
+            iov[cnt].iov_len = batch[j]->data.size() - s;
+        }
+        ssize_t n = ::writev(fd_, iov, cnt);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += (size_t)n;
+        size_t left = (size_t)n;
+        while (i < batch.size() && left >= batch[i]->data.size() - skip) {
+            left -= batch[i]->data.size() - skip;
+            skip = 0;
+            i++;
+        }
+        skip += left;
+    }
+#endif
+
+    uint64_t good = start; // end of the last complete line
+    for (auto& p : batch) {
+        AppendResult& r = p->result;
+        for (size_t e=0; e<p->ends.size(); e++) {
+            const uint64_t line_start = p->offset + (e ? p->ends[e - 1] : 0);
+            if (p->offset + p->ends[e] > start + written) break;
+            r.positions.push_back(make_position(seq_, line_start));
+            good = p->offset + p->ends[e];
+        }
+        if (r.positions.size() < p->ends.size()) r.error = "gagal menulis file store";
+    }
+    end_ = start + total;
+    // Cut the torn line so that the next batch starts on a line boundary.
+    if (written != total) truncate_to(good);
+}
+
+// Shrinks the active segment to offset, dropping records that were written
+// but failed; if that fails, re-reads the real end so later offsets stay
+// exact. Writer thread only.
+void AppendWriter::truncate_to(uint64_t offset) {
+#ifdef _WIN32
+    bool cut = _chsize_s(fd_, (__int64)offset) == 0;
+#else
+    bool cut = ftruncate(fd_, (off_t)offset) == 0;
+#endif
+    end_ = offset;
+    if (!cut) {
+#ifdef _WIN32
+        struct _stat64 st{};
+        if (_fstat64(fd_, &st) == 0) end_ = (uint64_t)st.st_size;
+#else
+        struct stat st{};
+        if (fstat(fd_, &st) == 0) end_ = (uint64_t)st.st_size;
+#endif
+    }
+}
+
+// Strict mode: the records were written but could not be synced, so their
+// callers are told they failed. Remove them from the file too, so that a
+// restart does not load records reported as failed. They are the last ones
+// written (every earlier sync succeeded or was cut the same way).
+void AppendWriter::fail_unsynced(PendingList& failed) {
+    uint64_t from = end_;
+    for (auto& p : failed) {
+        if (p->result.positions.empty()) continue;
+        from = std::min(from, p->offset);
+        p->result.positions.clear();
+        p->result.error = "gagal fsync file store";
+    }
+    if (from < end_) truncate_to(from);
+}
+
+bool AppendWriter::sync_now() {
+#ifdef _WIN32
+    return _commit(fd_) == 0;
+#elif defined(__linux__)
+    return fdatasync(fd_) == 0;
+#else
+    return fsync(fd_) == 0;
+#endif
+}
+
+// Syncs everything written so far and completes the strict-mode records it
+// covers; called by the writer thread holding lk.
+void AppendWriter::sync_locked(std::unique_lock<std::mutex>& lk) {
+    uint64_t upto = written_seq_;
+    lk.unlock();
+    bool ok = sync_now();
+    lk.lock();
+    syncs_++;
+    if (ok) durable_seq_ = upto;
+    PendingList finished;
+    auto covered = std::stable_partition(unsynced_.begin(), unsynced_.end(),
+                                         [upto](const std::unique_ptr<Pending>& p) { return p->seq > upto; });
+    for (auto it = covered; it != unsynced_.end(); ++it) finished.push_back(std::move(*it));
+    unsynced_.erase(covered, unsynced_.end());
+    if (!ok) fail_unsynced(finished);
+    complete(lk, finished);
+}
+
+// Runs the callbacks of finished records outside the lock.
+void AppendWriter::complete(std::unique_lock<std::mutex>& lk, PendingList& finished) {
+    if (finished.empty()) return;
+    lk.unlock();
+    for (auto& p : finished) p->done(std::move(p->result));
+    finished.clear();
+    lk.lock();
+}
+
+void AppendWriter::run() {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point next_sync{};
+    PendingList batch, finished;
+    std::unique_lock<std::mutex> lk(mu_);
+    for (;;) {
+        bool unsynced = opt_.sync != SyncPolicy::None && durable_seq_ < written_seq_;
+        if (queue_.empty() && !stop_) {
+            if (opt_.sync == SyncPolicy::Interval && unsynced) work_cv_.wait_until(lk, next_sync);
+            else work_cv_.wait(lk);
+        }
+
+        if (opt_.sync == SyncPolicy::Interval && unsynced && Clock::now() >= next_sync) {
+            sync_locked(lk);
+            next_sync = Clock::now() + std::chrono::milliseconds(opt_.sync_interval_ms);
+            continue;
+        }
+
+        if (!queue_.empty()) {
+            if (roll_due()) roll_locked(lk);
+            batch.swap(queue_);
+            lk.unlock();
+            write_batch(batch);
+            bool synced = opt_.sync == SyncPolicy::Batch && sync_now();
+            lk.lock();
+            uint64_t seq = ++written_seq_;
+            if (opt_.sync == SyncPolicy::Batch) {
+                syncs_++;
+                if (synced) durable_seq_ = seq;
+            } else if (opt_.sync == SyncPolicy::Interval && durable_seq_ + 1 == seq) {
+                // first unsynced batch since the last sync starts the clock
+                next_sync = Clock::now() + std::chrono::milliseconds(opt_.sync_interval_ms);
+            }
+            const bool strict = opt_.strict && opt_.sync != SyncPolicy::None;
+            for (auto& p : batch) {
+                p->seq = seq;
+                if (strict && opt_.sync == SyncPolicy::Interval && !p->result.positions.empty()) {
+                    unsynced_.push_back(std::move(p));
+                    continue;
+                }
+                finished.push_back(std::move(p));
+            }
+            if (strict && opt_.sync == SyncPolicy::Batch && !synced) fail_unsynced(finished);
+            batch.clear();
+            complete(lk, finished);
+            continue;
+        }
+
+        if (stop_) {
+            if (opt_.sync != SyncPolicy::None && durable_seq_ < written_seq_) sync_locked(lk);
+            break;
+        }
+    }
+}
+
 } // namespace filestore
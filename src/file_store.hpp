@@ -1,10 +1,230 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace filestore {
 
-bool append_line(const std::string& path, const std::string& line, std::string& err);
+// Appends line + '\n'. When offset is given it receives the byte offset at
+// which the line starts (callers must serialise appends for it to be exact).
+bool append_line(const std::string& path, const std::string& line, std::string& err,
+                 uint64_t* offset = nullptr);
 std::vector<std::string> read_lines(const std::string& path);
 
+// Calls fn for every non-empty line together with its byte offset. Reads
+// through a MappedLines, so lines are not copied.
+void for_each_line(const std::string& path, const std::function<void(std::string_view, uint64_t)>& fn);
+
+// Read-only memory mapping of a JSONL file with an index of its lines.
+// refresh() maps the file and indexes complete lines; called again after the
+// file has grown it remaps and indexes only the new bytes (a file that shrank
+// or was replaced is re-indexed from the start). Views returned by line() and
+// tail() stay valid until the next refresh() or destruction.
+class MappedLines {
+public:
+    explicit MappedLines(std::string path);
+    ~MappedLines();
+    MappedLines(const MappedLines&) = delete;
+    MappedLines& operator=(const MappedLines&) = delete;
+
+    // A missing file is an empty store, not an error.
+    bool refresh(std::string& err);
+
+    size_t size() const { return lines_.size(); } // non-empty lines
+    std::string_view line(size_t i) const { return {data_ + lines_[i].offset, lines_[i].len}; }
+    uint64_t offset(size_t i) const { return lines_[i].offset; }
+    // Bytes after the last newline (a line still being written, or torn).
+    std::string_view tail() const { return {data_ + scanned_, mapped_ - scanned_}; }
+    uint64_t mapped_bytes() const { return mapped_; }
+
+private:
+    struct Span {
+        uint64_t offset;
+        uint32_t len; // without the newline (and a trailing '\r')
+    };
+
+    void unmap();
+
+    std::string path_;
+    const char* data_ = nullptr;
+    size_t mapped_ = 0;
+    size_t scanned_ = 0; // offset just past the last indexed newline
+    uint64_t file_id_[2] = {0, 0}; // device/inode (volume/index on Windows)
+    std::vector<Span> lines_;
+};
+
+// ---------------------------------------------------------------------------
+// Segmented store.
+//
+// A store named e.g. data/assets.jsonl consists of, in read order:
+//   data/assets.snapshot.<seq>.jsonl  newest compacted snapshot (optional),
+//                                     replacing every segment up to <seq>
+//   data/assets.<seq>.jsonl           sealed segments with seq > snapshot
+//   data/assets.jsonl                 the active segment being appended to
+// The active segment is sealed by renaming it once it reaches a size or age
+// limit. A store that never rolls over is just the single JSONL file.
+
+// Position of a line in a segmented store: the segment's sequence number in
+// the high bits and the byte offset within it in the low 40. Positions grow
+// in append order across rollovers and compaction.
+constexpr int kSegmentOffsetBits = 40;
+inline uint64_t make_position(uint64_t seq, uint64_t offset) { return (seq << kSegmentOffsetBits) | offset; }
+
+struct Segment {
+    enum class Kind { Snapshot, Sealed, Active };
+    Kind kind;
+    uint64_t seq; // Active: the seq it will be sealed under
+    std::string path;
+};
+
+// Files that currently make up the store, in read order. Stale files left by
+// an interrupted compaction (older snapshots, segments it already covers,
+// temporaries) are skipped.
+std::vector<Segment> list_segments(const std::string& path);
+
+// Deletes the stale files list_segments skips; run before opening the store.
+void remove_stale_segments(const std::string& path);
+
+// Calls fn for every non-empty line of every segment, with its position.
+void for_each_record(const std::string& path, const std::function<void(std::string_view, uint64_t)>& fn);
+
+// Maps a line to its compaction key; false drops the line.
+using CompactKeyFn = std::function<bool(std::string_view line, std::string& key)>;
+
+struct CompactStats {
+    size_t segments = 0;  // files merged (0: nothing to compact)
+    size_t lines_in = 0;
+    size_t lines_out = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    uint64_t seq = 0;     // seq of the new snapshot
+};
+
+// Merges the newest snapshot and all sealed segments into a new snapshot
+// that keeps, in store order, only the last line for each key. The snapshot
+// is written to a temporary file, synced and then renamed into place, so a
+// crash at any point leaves either the old or the new set of files readable;
+// the merged inputs are deleted afterwards. The active segment is not
+// touched, so this can run while an AppendWriter is appending.
+bool compact(const std::string& path, const CompactKeyFn& key, CompactStats& stats, std::string& err);
+
+// When appended data is flushed to stable storage.
+enum class SyncPolicy {
+    None,     // never; the OS writes it back on its own schedule
+    Interval, // at most every sync_interval_ms, covering everything written so far
+    Batch,    // after every batch (group commit)
+};
+
+struct WriterOptions {
+    SyncPolicy sync = SyncPolicy::None;
+    int sync_interval_ms = 1000;
+    // Strict: an append completes only once the record is durable under the
+    // sync policy (with SyncPolicy::None that is the same as written).
+    // Otherwise it completes once the record has been written.
+    bool strict = false;
+    // Seal the active segment once it holds this many bytes / is this old
+    // (0 = no limit). Checked before each batch.
+    uint64_t segment_bytes = 0;
+    int segment_seconds = 0;
+};
+
+// Outcome of one append call.
+struct AppendResult {
+    // make_position() of each line that was stored, in order. After a failed
+    // write this covers the lines before the failure (the torn rest is
+    // truncated away); after a failed sync in strict mode it is empty and
+    // the lines are truncated away as well.
+    std::vector<uint64_t> positions;
+    std::string error; // empty when every line was stored
+};
+
+// Runs on the writer thread, without the writer's lock held: it should only
+// hand the result over to the thread that owns the request.
+using AppendDone = std::function<void(AppendResult&&)>;
+
+// Appender for the active segment of a store, shared by many threads. The
+// file stays open; a background thread drains all records queued since its
+// last write into one writev call (one batch) and fsyncs per the policy, so
+// concurrent callers share both the write and the fsync. Completion is
+// reported per call through a callback, so event-loop threads never wait
+// for the disk; append() and append_many() are blocking wrappers.
+class AppendWriter {
+public:
+    AppendWriter(std::string path, WriterOptions opt);
+    ~AppendWriter(); // drains pending records, syncs and closes
+    AppendWriter(const AppendWriter&) = delete;
+    AppendWriter& operator=(const AppendWriter&) = delete;
+
+    bool open(std::string& err);
+    void close();
+
+    // Appends every line (each + '\n') as one contiguous write, so they land
+    // together in one segment and share one sync. done is called once the
+    // lines are written (durable in strict mode), or immediately when the
+    // writer is not open.
+    void append_async(const std::vector<std::string>& lines, AppendDone done);
+
+    // Appends line + '\n' and blocks until it is written (or durable in
+    // strict mode). position receives the line's make_position().
+    bool append(std::string line, std::string& err, uint64_t* position = nullptr);
+
+    // Blocking append_async. Returns false unless every line was stored;
+    // positions then still receives those that were.
+    bool append_many(const std::vector<std::string>& lines, std::string& err,
+                     std::vector<uint64_t>* positions = nullptr);
+
+    const std::string& path() const { return path_; }
+    uint64_t batches() const;
+    uint64_t syncs() const;
+    uint64_t rollovers() const;
+
+private:
+    struct Pending {
+        std::string data;          // the lines, each including '\n'
+        std::vector<size_t> ends;  // end of each line in data
+        uint64_t offset = 0;       // of data in the active segment
+        uint64_t seq = 0;    // batch sequence number once written
+        AppendResult result;
+        AppendDone done;
+    };
+    using PendingList = std::vector<std::unique_ptr<Pending>>;
+
+    void run();
+    void write_batch(PendingList& batch);
+    bool sync_now();
+    void sync_locked(std::unique_lock<std::mutex>& lk);
+    void complete(std::unique_lock<std::mutex>& lk, PendingList& finished);
+    void truncate_to(uint64_t offset);
+    void fail_unsynced(PendingList& failed);
+    bool open_active(std::string& err);
+    void close_active();
+    bool roll_due() const;
+    void roll_locked(std::unique_lock<std::mutex>& lk);
+
+    std::string path_;
+    WriterOptions opt_;
+    int fd_ = -1;
+    uint64_t end_ = 0; // file size == offset of the next line
+    uint64_t seq_ = 0; // active segment's seq
+    std::chrono::steady_clock::time_point opened_at_;
+
+    mutable std::mutex mu_;
+    std::condition_variable work_cv_;  // writer thread: records queued / stop
+    PendingList queue_;
+    PendingList unsynced_; // strict interval mode: written, waiting for the next sync
+    bool stop_ = false;
+    uint64_t written_seq_ = 0; // last batch written
+    uint64_t durable_seq_ = 0; // last batch known to be on stable storage
+    uint64_t syncs_ = 0;
+    uint64_t rollovers_ = 0;
+    std::thread thread_;
+};
+
 } // namespace filestore
@@ -0,0 +1,336 @@
+#include "fleet_sim.hpp"
+#include "http_client.hpp"
+#include "inventory.hpp"
+#include "logger.hpp"
+#include "mini_json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <random>
+#include <thread>
+
+namespace fleetsim {
+
+// ---------------------------------------------------------------------------
+// LatencyHistogram
+
+static constexpr int kSubBits = 6; // 64 sub-buckets per power of two
+
+static int msb64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int m = 0;
+    while (v >>= 1) m++;
+    return m;
+#endif
+}
+
+LatencyHistogram::LatencyHistogram() : counts_(index_of(~0ULL) + 1, 0) {}
+
+size_t LatencyHistogram::index_of(uint64_t v) {
+    if (v < (2u << kSubBits)) return (size_t)v;
+    const int shift = msb64(v) - kSubBits;
+    return ((size_t)shift << kSubBits) + (size_t)(v >> shift);
+}
+
+uint64_t LatencyHistogram::value_at(size_t i) {
+    if (i < (2u << kSubBits)) return i;
+    const size_t shift = (i >> kSubBits) - 1;
+    return (uint64_t)(i - (shift << kSubBits)) << shift;
+}
+
+void LatencyHistogram::record(uint64_t us) {
+    counts_[index_of(us)]++;
+    count_++;
+    max_ = std::max(max_, us);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& o) {
+    for (size_t i=0;i<counts_.size();i++) counts_[i] += o.counts_[i];
+    count_ += o.count_;
+    max_ = std::max(max_, o.max_);
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    if (!count_) return 0;
+    const uint64_t target = std::max<uint64_t>(1, (uint64_t)std::ceil(q * (double)count_));
+    uint64_t seen = 0;
+    for (size_t i=0;i<counts_.size();i++) {
+        seen += counts_[i];
+        if (seen >= target) return std::min(value_at(i), max_);
+    }
+    return max_;
+}
+
+// ---------------------------------------------------------------------------
+// Payload templates
+
+namespace {
+
+struct Slot {
+    size_t offset = 0;
+    size_t width = 0;
+};
+
+struct Template {
+    std::string body; // pretty JSON, as asset_agent sends it
+    Slot asset_id, hostname, timestamp;
+    std::vector<Slot> free_gb;
+    std::vector<long long> total_gb;
+};
+
+constexpr int kTemplates = 64;
+// Placeholders, replaced in place; the numeric one is padded with spaces
+// after the digits, which JSON allows.
+const char* const kIdMark = "################";   // 16 hex digits
+const char* const kHostMark = "%%%%%%%%";          // 8 hex digits
+const char* const kTimeMark = "YYYY-MM-DDTHH:MM:SSZ";
+constexpr long long kFreeMark = 900000000;         // + disk index, 9 digits
+
+struct Weighted {
+    const char* name;
+    int weight;
+    bool windows;
+};
+
+const Weighted kOs[] = {
+    {"Windows 10 (build 19045)", 30, true},
+    {"Windows 11 (build 22631)", 25, true},
+    {"Ubuntu 22.04.4 LTS", 20, false},
+    {"Ubuntu 24.04.1 LTS", 10, false},
+    {"Debian GNU/Linux 12 (bookworm)", 10, false},
+    {"Rocky Linux 9.4 (Blue Onyx)", 5, false},
+};
+const char* const kCpus[] = {
+    "Intel(R) Core(TM) i5-8250U CPU @ 1.60GHz",
+    "Intel(R) Core(TM) i7-1165G7 @ 2.80GHz",
+    "AMD Ryzen 7 5800X 8-Core Processor",
+    "AMD EPYC 7543 32-Core Processor",
+    "Intel(R) Xeon(R) Gold 6226R CPU @ 2.90GHz",
+};
+const int kCores[] = {2, 4, 8, 12, 16, 32};
+const long long kRamMb[] = {4096, 8192, 16384, 32768, 65536};
+const long long kDiskGb[] = {128, 237, 256, 476, 512, 931, 1024, 1863, 3726};
+const char* const kWinMounts[] = {"C:\\", "D:\\", "E:\\"};
+const char* const kUnixMounts[] = {"/", "/home", "/var", "/data"};
+
+uint64_t mix64(uint64_t x) {
+    // splitmix64 finaliser
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+bool find_slot(const std::string& body, const std::string& mark, Slot& slot) {
+    slot.offset = body.find(mark);
+    slot.width = mark.size();
+    return slot.offset != std::string::npos;
+}
+
+bool make_template(std::mt19937_64& rng, const std::string& agent_version, Template& t) {
+    using minijson::Value;
+    int total = 0;
+    for (const auto& o : kOs) total += o.weight;
+    int pick = std::uniform_int_distribution<int>(0, total - 1)(rng);
+    const Weighted* os = &kOs[0];
+    for (const auto& o : kOs) {
+        if (pick < o.weight) { os = &o; break; }
+        pick -= o.weight;
+    }
+    auto any = [&rng](size_t n) { return std::uniform_int_distribution<size_t>(0, n - 1)(rng); };
+
+    const size_t max_disks = os->windows ? 3 : 4;
+    const size_t disks = 1 + any(max_disks);
+    std::vector<Value> disk_arr;
+    t.total_gb.clear();
+    for (size_t d=0;d<disks;d++) {
+        long long gb = kDiskGb[any(sizeof(kDiskGb) / sizeof(kDiskGb[0]))];
+        t.total_gb.push_back(gb);
+        disk_arr.push_back(Value::object({
+            {"mount", Value::string(os->windows ? kWinMounts[d] : kUnixMounts[d])},
+            {"total_gb", Value::number((double)gb)},
+            {"free_gb", Value::number((double)(kFreeMark + (long long)d))},
+        }));
+    }
+    Value root = Value::object({
+        {"asset_id", Value::string(std::string("asset-") + kIdMark)},
+        {"hostname", Value::string(std::string(os->windows ? "ws-" : "srv-") + kHostMark)},
+        {"os", Value::string(os->name)},
+        {"cpu_model", Value::string(kCpus[any(sizeof(kCpus) / sizeof(kCpus[0]))])},
+        {"cpu_cores", Value::number((double)kCores[any(sizeof(kCores) / sizeof(kCores[0]))])},
+        {"ram_total_mb", Value::number((double)kRamMb[any(sizeof(kRamMb) / sizeof(kRamMb[0]))])},
+        {"disks", Value::array(std::move(disk_arr))},
+        {"timestamp_utc", Value::string(kTimeMark)},
+        {"agent_version", Value::string(agent_version)},
+    });
+    t.body = minijson::stringify(root, true);
+    if (!find_slot(t.body, kIdMark, t.asset_id) || !find_slot(t.body, kHostMark, t.hostname) ||
+        !find_slot(t.body, kTimeMark, t.timestamp)) return false;
+    t.free_gb.resize(disks);
+    for (size_t d=0;d<disks;d++) {
+        if (!find_slot(t.body, std::to_string(kFreeMark + (long long)d), t.free_gb[d])) return false;
+    }
+    return true;
+}
+
+// Writes agent's identity and this report's values into body (a copy of
+// t.body). free_gb drifts per report.
+void stamp(const Template& t, uint64_t agent, uint64_t report, const char* timestamp, std::string& body) {
+    body.assign(t.body);
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)mix64(agent));
+    body.replace(t.asset_id.offset, t.asset_id.width, buf, 16);
+    std::snprintf(buf, sizeof(buf), "%08llx", (unsigned long long)(agent & 0xffffffffULL));
+    body.replace(t.hostname.offset, t.hostname.width, buf, 8);
+    body.replace(t.timestamp.offset, t.timestamp.width, timestamp, 20);
+    for (size_t d=0;d<t.free_gb.size();d++) {
+        const long long total = t.total_gb[d];
+        const long long free_gb = (long long)(mix64(agent * 31 + d) % (uint64_t)total) * (100 - (long long)(report % 20)) / 100;
+        const Slot& s = t.free_gb[d];
+        int n = std::snprintf(buf, sizeof(buf), "%lld", free_gb);
+        std::fill(buf + n, buf + s.width, ' ');
+        body.replace(s.offset, s.width, buf, s.width);
+    }
+}
+
+// timestamp_utc for now, reformatted once per second.
+struct UtcStamp {
+    std::time_t last = 0;
+    char text[24] = {};
+
+    const char* now() {
+        std::time_t t = std::time(nullptr);
+        if (t != last) {
+            std::tm tm{};
+#ifdef _WIN32
+            gmtime_s(&tm, &t);
+#else
+            gmtime_r(&t, &tm);
+#endif
+            std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &tm);
+            last = t;
+        }
+        return text;
+    }
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+
+Result run(const Options& opt) {
+    Result total;
+    std::vector<Template> templates(kTemplates);
+    std::mt19937_64 rng(20260213);
+    for (auto& t : templates) {
+        std::string body, why;
+        if (!make_template(rng, opt.agent_version, t)) {
+            total.error = "template slot tidak ditemukan";
+            return total;
+        }
+        stamp(t, 0, 0, "2026-01-01T00:00:00Z", body);
+        bool valid = false;
+        try {
+            valid = inventory::validate_asset_schema(minijson::parse(body), why);
+        } catch (const std::exception& e) {
+            why = e.what();
+        }
+        if (!valid) {
+            total.error = "template tidak valid: " + why;
+            return total;
+        }
+    }
+
+    const int conns = std::max(1, opt.concurrency);
+    const uint64_t agents = std::max<uint64_t>(1, opt.agents);
+    using SteadyClock = std::chrono::steady_clock;
+    const auto start = SteadyClock::now();
+    const auto end = start + std::chrono::duration_cast<SteadyClock::duration>(std::chrono::duration<double>(opt.duration_s));
+    std::atomic<uint64_t> next{0};
+    std::vector<Result> results(conns);
+    std::vector<std::thread> workers;
+    for (int w=0;w<conns;w++) {
+        workers.emplace_back([&, w] {
+            Result& r = results[w];
+            httpclient::Connection conn(opt.host, opt.port, opt.timeout_ms);
+            UtcStamp clock;
+            std::string body;
+            for (;;) {
+                const uint64_t k = next.fetch_add(1, std::memory_order_relaxed);
+                if (opt.duration_s <= 0 && k >= agents) break;
+                // Open loop: report k is due at start + k / rate, whether or
+                // not earlier ones have been answered.
+                auto due = SteadyClock::now();
+                if (opt.rate > 0) {
+                    due = start + std::chrono::duration_cast<SteadyClock::duration>(
+                        std::chrono::duration<double>((double)k / opt.rate));
+                }
+                if (opt.duration_s > 0 && due >= end) break;
+                if (opt.rate > 0) std::this_thread::sleep_until(due);
+
+                const uint64_t agent = k % agents;
+                const Template& t = templates[mix64(agent ^ 0x5eed) % kTemplates];
+                stamp(t, agent, k / agents, clock.now(), body);
+                auto resp = conn.post_json(opt.path, body);
+                const auto done = SteadyClock::now();
+                const uint64_t us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(done - due).count();
+                if (resp.error.empty() && resp.status >= 200 && resp.status < 300) {
+                    r.ok++;
+                    r.bytes += body.size();
+                    r.latency.record(us);
+                } else {
+                    // Kept apart: fast rejections or slow timeouts would
+                    // otherwise skew the success percentiles either way.
+                    r.failed++;
+                    r.failed_latency.record(us);
+                    if (r.failed == 1) {
+                        logutil::warn("simulate", resp.error.empty() ? "HTTP " + std::to_string(resp.status) : resp.error);
+                    }
+                }
+                if (opt.duration_s > 0 && done >= end) break;
+            }
+        });
+    }
+    for (auto& t : workers) t.join();
+    total.seconds = std::chrono::duration<double>(SteadyClock::now() - start).count();
+    for (const auto& r : results) {
+        total.ok += r.ok;
+        total.failed += r.failed;
+        total.bytes += r.bytes;
+        total.latency.merge(r.latency);
+        total.failed_latency.merge(r.failed_latency);
+    }
+    return total;
+}
+
+std::string summary(const Options& opt, const Result& r) {
+    char buf[512];
+    std::string out;
+    std::snprintf(buf, sizeof(buf), "simulated agents: %llu, connections: %d, target rate: ",
+                  (unsigned long long)opt.agents, opt.concurrency);
+    out += buf;
+    if (opt.rate > 0) std::snprintf(buf, sizeof(buf), "%g/s\n", opt.rate);
+    else std::snprintf(buf, sizeof(buf), "unlimited\n");
+    out += buf;
+    const double secs = r.seconds > 0 ? r.seconds : 1e-9;
+    std::snprintf(buf, sizeof(buf), "reports: %llu ok, %llu failed in %.2f s -> %.0f reports/s (%.1f MB/s of payload)\n",
+                  (unsigned long long)r.ok, (unsigned long long)r.failed, r.seconds, (double)r.ok / secs,
+                  (double)r.bytes / 1048576.0 / secs);
+    out += buf;
+    auto latency = [&](const char* label, const LatencyHistogram& h) {
+        std::snprintf(buf, sizeof(buf), "%s (ms): p50 %.3f  p90 %.3f  p99 %.3f  p99.9 %.3f  max %.3f\n", label,
+                      h.percentile(0.50) / 1000.0, h.percentile(0.90) / 1000.0, h.percentile(0.99) / 1000.0,
+                      h.percentile(0.999) / 1000.0, h.max() / 1000.0);
+        out += buf;
+    };
+    latency("latency", r.latency);
+    if (r.failed) latency("failed latency", r.failed_latency);
+    return out;
+}
+
+} // namespace fleetsim
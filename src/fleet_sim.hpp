@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Fleet simulator for capacity planning (asset_agent --simulate N): posts
+// payloads for N synthetic agents over persistent connections and reports
+// throughput and latency percentiles.
+namespace fleetsim {
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    std::string path = "/api/assets";
+    int timeout_ms = 2000;
+    std::string agent_version = "1.0.0";
+    uint64_t agents = 1000;
+    // Target reports per second across all connections; 0 = as fast as the
+    // server answers (closed loop).
+    double rate = 0;
+    int concurrency = 16;
+    // Keep cycling through the fleet for this long; 0 = every agent reports
+    // once.
+    double duration_s = 0;
+};
+
+// Log-linear latency histogram (HdrHistogram-style): exact below 128 us,
+// then 64 sub-buckets per power of two, i.e. within ~1.6% of the true
+// value up to hours. Recording is an index computation and an increment.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+    void record(uint64_t us);
+    void merge(const LatencyHistogram& o);
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+    // Smallest recorded bucket value at or above fraction q (0..1) of the
+    // samples.
+    uint64_t percentile(double q) const;
+
+private:
+    static size_t index_of(uint64_t v);
+    static uint64_t value_at(size_t i);
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    uint64_t max_ = 0;
+};
+
+struct Result {
+    uint64_t ok = 0;       // 2xx
+    uint64_t failed = 0;   // transport errors and non-2xx
+    uint64_t bytes = 0;    // request bodies sent
+    double seconds = 0;
+    // Measured from the scheduled send time when rate-limited, so a server
+    // that falls behind shows up as latency rather than as a lower rate
+    // (no coordinated omission).
+    LatencyHistogram latency;        // 2xx
+    LatencyHistogram failed_latency; // the rest, up to the error or response
+    std::string error;     // set when the run could not start
+};
+
+// Payloads are stamped from pre-serialised templates: one per distinct
+// (OS, CPU, RAM, disk layout) combination, with fixed-width slots for
+// asset_id, hostname, timestamp_utc and each disk's free_gb that are
+// overwritten in place for every report. Agent i always uses the same
+// template and identity, so repeated runs update the same assets.
+Result run(const Options& opt);
+
+// Human-readable summary (throughput, percentiles) for stdout.
+std::string summary(const Options& opt, const Result& r);
+
+} // namespace fleetsim
@@ -1,5 +1,7 @@
 #include "http_client.hpp"
 #include "logger.hpp"
+#include "http_parser.hpp"
+#include <cerrno>
 #include <cstring>
 #include <sstream>
 
@@ -40,7 +42,7 @@ static void sock_cleanup() {
 #endif
 }
 
-static int connect_tcp(const std::string& host, int port, int timeout_ms, std::string& err) {
+static bool resolve_tcp(const std::string& host, int port, std::vector<httpclient::Endpoint>& out, std::string& err) {
     struct addrinfo hints{};
     hints.ai_family = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
@@ -48,16 +50,25 @@ static int connect_tcp(const std::string& host, int port, int timeout_ms, std::s
     struct addrinfo* res = nullptr;
     std::string port_s = std::to_string(port);
     int rc = getaddrinfo(host.c_str(), port_s.c_str(), &hints, &res);
-    if (rc != 0 || !res) { err = "DNS/addrinfo gagal"; return -1; }
+    if (rc != 0 || !res) { err = "DNS/addrinfo gagal"; return false; }
+    out.clear();
+    for (auto p=res; p; p=p->ai_next) {
+        out.push_back({p->ai_family, p->ai_socktype, p->ai_protocol,
+                       std::string((const char*)p->ai_addr, (size_t)p->ai_addrlen)});
+    }
+    freeaddrinfo(res);
+    return true;
+}
 
+static int connect_tcp(const std::vector<httpclient::Endpoint>& addrs, int timeout_ms, std::string& err) {
     int fd = -1;
-    for (auto p=res; p; p=p->ai_next) {
+    for (const auto& a : addrs) {
 #ifdef _WIN32
-        SOCKET s = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+        SOCKET s = socket(a.family, a.socktype, a.protocol);
         if (s == INVALID_SOCKET) continue;
         fd = (int)s;
 #else
-        fd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+        fd = socket(a.family, a.socktype, a.protocol);
         if (fd < 0) continue;
 #endif
 
@@ -80,8 +91,7 @@ static int connect_tcp(const std::string& host, int port, int timeout_ms, std::s
 #else
             fd,
 #endif
-            p->ai_addr, (int)p->ai_addrlen) == 0) {
-            freeaddrinfo(res);
+            (const struct sockaddr*)a.addr.data(), (int)a.addr.size()) == 0) {
             return fd;
         }
 
@@ -89,17 +99,28 @@ static int connect_tcp(const std::string& host, int port, int timeout_ms, std::s
         fd = -1;
     }
 
-    freeaddrinfo(res);
     err = "connect gagal (timeout/network unreachable)";
     return -1;
 }
 
+// The peer reset the connection (as opposed to a receive timeout).
+static bool conn_reset() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAECONNRESET;
+#else
+    return errno == ECONNRESET;
+#endif
+}
+
 static bool send_all(int fd, const std::string& data) {
     const char* p = data.c_str();
     size_t left = data.size();
     while (left > 0) {
 #ifdef _WIN32
         int n = send((SOCKET)fd, p, (int)left, 0);
+#elif defined(MSG_NOSIGNAL)
+        // a kept-alive socket may have been closed by the server: no SIGPIPE
+        ssize_t n = send(fd, p, left, MSG_NOSIGNAL);
 #else
         ssize_t n = send(fd, p, left, 0);
 #endif
@@ -110,71 +131,146 @@ static bool send_all(int fd, const std::string& data) {
     return true;
 }
 
-static std::string recv_some(int fd) {
-    char buf[4096];
-#ifdef _WIN32
-    int n = recv((SOCKET)fd, buf, (int)sizeof(buf), 0);
-#else
-    ssize_t n = recv(fd, buf, sizeof(buf), 0);
-#endif
-    if (n <= 0) return {};
-    return std::string(buf, buf + n);
-}
-
 namespace httpclient {
 
-Response post_json(const std::string& host, int port, const std::string& path,
-                   const std::string& json_body, int timeout_ms) {
-    Response r;
-    std::string err;
-    if (!sock_init(err)) { r.error = err; return r; }
+Connection::Connection(std::string host, int port, int timeout_ms)
+    : host_(std::move(host)), port_(port), timeout_ms_(timeout_ms) {}
+
+Connection::~Connection() {
+    close();
+    if (sock_ready_) sock_cleanup();
+}
 
-    int fd = connect_tcp(host, port, timeout_ms, err);
-    if (fd < 0) { r.error = err; sock_cleanup(); return r; }
+void Connection::close() {
+    if (fd_ >= 0) sock_close(fd_);
+    fd_ = -1;
+    server_closing_ = false;
+    buf_.clear();
+}
+
+bool Connection::open(std::string& err) {
+    if (!sock_ready_) {
+        if (!sock_init(err)) return false;
+        sock_ready_ = true;
+    }
+    // The address is resolved once and reused for reconnects; a failed
+    // connect drops it so that the next attempt resolves the host again.
+    if (addrs_.empty() && !resolve_tcp(host_, port_, addrs_, err)) return false;
+    fd_ = connect_tcp(addrs_, timeout_ms_, err);
+    if (fd_ < 0) addrs_.clear();
+    return fd_ >= 0;
+}
 
+std::string Connection::build_post(const std::string& path, const std::string& json_body) const {
     std::ostringstream req;
     req << "POST " << path << " HTTP/1.1\r\n";
-    req << "Host: " << host << ":" << port << "\r\n";
+    req << "Host: " << host_ << ":" << port_ << "\r\n";
     req << "Content-Type: application/json\r\n";
-    req << "Connection: close\r\n";
+    req << "Connection: keep-alive\r\n";
     req << "Content-Length: " << json_body.size() << "\r\n\r\n";
     req << json_body;
+    return req.str();
+}
 
-    if (!send_all(fd, req.str())) {
-        r.error = "send gagal";
-        sock_close(fd);
-        sock_cleanup();
-        return r;
+// Reads one response; bytes past its end stay in buf_ for the next call.
+// closed_early_ is set when the server closed or reset the connection
+// before sending any byte of it.
+bool Connection::read_response(Response& r) {
+    closed_early_ = false;
+    httpparser::Parser parser(httpparser::Kind::Response);
+    auto st = buf_.empty() ? httpparser::Status::Incomplete : parser.parse(buf_);
+    char tmp[4096];
+    while (st == httpparser::Status::Incomplete) {
+#ifdef _WIN32
+        int n = recv((SOCKET)fd_, tmp, (int)sizeof(tmp), 0);
+#else
+        ssize_t n = recv(fd_, tmp, sizeof(tmp), 0);
+#endif
+        if (n < 0) {
+            if (buf_.empty() && conn_reset()) { r.error = "koneksi ditutup server"; closed_early_ = true; return false; }
+            r.error = "recv gagal (timeout)";
+            return false;
+        }
+        if (n == 0) {
+            if (buf_.empty()) { r.error = "koneksi ditutup server"; closed_early_ = true; return false; }
+            st = parser.finish_at_eof(buf_);
+            server_closing_ = true;
+            break;
+        }
+        buf_.append(tmp, tmp + n);
+        st = parser.parse(buf_);
+    }
+    if (st != httpparser::Status::Complete) { r.error = "response tidak valid: " + parser.error(); return false; }
+
+    const auto& resp = parser.response();
+    r.status = resp.status;
+    r.body.assign(resp.body.data(), resp.body.size());
+    if (!resp.keep_alive()) server_closing_ = true;
+    buf_.erase(0, parser.consumed());
+    return true;
+}
+
+Response Connection::post_json(const std::string& path, const std::string& json_body) {
+    std::string req = build_post(path, json_body);
+    Response r;
+    // A reused socket may have been closed by the server's idle timeout; in
+    // that case reconnect once and resend. The POST is not idempotent, so it
+    // is resent only when it cannot have reached the server: the send failed,
+    // or the server closed the socket without answering. A timeout or a
+    // broken response may follow a stored record and is returned as is.
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = fd_ >= 0;
+        r = Response{};
+        std::string err;
+        if (!reused && !open(err)) { r.error = err; return r; }
+
+        if (!send_all(fd_, req)) {
+            r.error = "send gagal";
+            close();
+            if (reused) continue;
+            return r;
+        }
+        bool ok = read_response(r);
+        if (!ok || server_closing_) close();
+        if (ok || !reused || !closed_early_) return r;
     }
+    return r;
+}
+
+std::vector<Response> Connection::post_json_pipelined(const std::string& path, const std::vector<std::string>& bodies) {
+    std::vector<Response> out(bodies.size());
+    if (bodies.empty()) return out;
 
-    std::string resp;
-    for (;;) {
-        std::string chunk = recv_some(fd);
-        if (chunk.empty()) break;
-        resp += chunk;
-        if (resp.size() > 2*1024*1024) break; // guard
+    std::string err;
+    if (fd_ < 0 && !open(err)) {
+        for (auto& r : out) r.error = err;
+        return out;
     }
 
-    sock_close(fd);
-    sock_cleanup();
-
-    // parse status line
-    auto pos = resp.find("\r\n");
-    std::string status_line = (pos==std::string::npos) ? resp : resp.substr(0,pos);
-    int status = 0;
-    {
-        std::istringstream ss(status_line);
-        std::string httpver;
-        ss >> httpver >> status;
+    std::string batch;
+    for (const auto& b : bodies) batch += build_post(path, b);
+    if (!send_all(fd_, batch)) {
+        close();
+        for (auto& r : out) r.error = "send gagal";
+        return out;
     }
-    r.status = status;
 
-    // body (very simple)
-    auto sep = resp.find("\r\n\r\n");
-    if (sep != std::string::npos) r.body = resp.substr(sep + 4);
-    else r.body = "";
+    size_t i = 0;
+    for (; i < out.size(); i++) {
+        if (!read_response(out[i])) break;
+        if (server_closing_) { i++; break; }
+    }
+    for (size_t k = i; k < out.size(); k++) {
+        if (out[k].error.empty() && out[k].status == 0) out[k].error = "koneksi ditutup sebelum response";
+    }
+    if (i < out.size() || server_closing_) close();
+    return out;
+}
 
-    return r;
+Response post_json(const std::string& host, int port, const std::string& path,
+                   const std::string& json_body, int timeout_ms) {
+    Connection c(host, port, timeout_ms);
+    return c.post_json(path, json_body);
 }
 
 } // namespace httpclient
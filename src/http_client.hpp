@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 
 namespace httpclient {
 
@@ -9,6 +10,53 @@ struct Response {
     std::string error;
 };
 
+// Resolved address of a Connection's host (sockaddr bytes).
+struct Endpoint {
+    int family;
+    int socktype;
+    int protocol;
+    std::string addr;
+};
+
+// Persistent HTTP/1.1 connection to one host. The socket is opened lazily,
+// kept alive between requests and transparently re-opened (once per request)
+// when the server has closed it in the meantime; a request that may have
+// reached the server is never resent. The host is resolved on the first
+// connect only, until a connect fails.
+class Connection {
+public:
+    Connection(std::string host, int port, int timeout_ms);
+    ~Connection();
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    Response post_json(const std::string& path, const std::string& json_body);
+
+    // Pipelines all bodies over the socket, then reads the responses in order.
+    // If the server closes early, the unanswered entries carry an error and
+    // may be resent.
+    std::vector<Response> post_json_pipelined(const std::string& path, const std::vector<std::string>& bodies);
+
+    bool is_open() const { return fd_ >= 0; }
+    void close();
+
+private:
+    bool open(std::string& err);
+    std::string build_post(const std::string& path, const std::string& json_body) const;
+    bool read_response(Response& r);
+
+    std::string host_;
+    int port_;
+    int timeout_ms_;
+    std::vector<Endpoint> addrs_;
+    int fd_ = -1;
+    bool sock_ready_ = false;
+    bool server_closing_ = false;
+    bool closed_early_ = false;
+    std::string buf_;
+};
+
+// One-shot helper: opens a connection, posts, closes.
 Response post_json(const std::string& host, int port, const std::string& path,
                    const std::string& json_body, int timeout_ms);
 
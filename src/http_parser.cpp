@@ -0,0 +1,303 @@
+#include "http_parser.hpp"
+#include <charconv>
+
+namespace httpparser {
+
+static char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i=0;i<a.size();i++) if (lower(a[i]) != lower(b[i])) return false;
+    return true;
+}
+
+static bool icontains(std::string_view hay, std::string_view needle) {
+    if (needle.size() > hay.size()) return false;
+    for (size_t i=0;i+needle.size()<=hay.size();i++) {
+        if (iequals(hay.substr(i, needle.size()), needle)) return true;
+    }
+    return false;
+}
+
+static std::string_view trim(std::string_view v) {
+    while (!v.empty() && (v.front()==' ' || v.front()=='\t')) v.remove_prefix(1);
+    while (!v.empty() && (v.back()==' ' || v.back()=='\t')) v.remove_suffix(1);
+    return v;
+}
+
+static std::string_view find_header(const std::vector<Header>& headers, std::string_view name) {
+    for (const auto& h : headers) if (iequals(h.name, name)) return h.value;
+    return {};
+}
+
+static bool wants_keep_alive(std::string_view version, std::string_view connection) {
+    if (icontains(connection, "close")) return false;
+    if (version == "HTTP/1.0") return icontains(connection, "keep-alive");
+    return true;
+}
+
+std::string_view Request::header(std::string_view name) const { return find_header(headers, name); }
+bool Request::keep_alive() const { return wants_keep_alive(version, header("connection")); }
+
+std::string_view Request::path() const { return target.substr(0, target.find('?')); }
+
+std::string_view Request::query() const {
+    size_t q = target.find('?');
+    return q == std::string_view::npos ? std::string_view() : target.substr(q + 1);
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static std::string url_decode(std::string_view s) {
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i=0;i<s.size();i++) {
+        char c = s[i];
+        int hi, lo;
+        if (c == '+') out += ' ';
+        else if (c == '%' && i + 2 < s.size() && (hi = hex_digit(s[i+1])) >= 0 && (lo = hex_digit(s[i+2])) >= 0) {
+            out += (char)(hi * 16 + lo);
+            i += 2;
+        }
+        else out += c; // stray '%' is kept literally
+    }
+    return out;
+}
+
+std::vector<QueryParam> parse_query(std::string_view query) {
+    std::vector<QueryParam> out;
+    while (!query.empty()) {
+        size_t amp = query.find('&');
+        std::string_view pair = query.substr(0, amp);
+        query = amp == std::string_view::npos ? std::string_view() : query.substr(amp + 1);
+        if (pair.empty()) continue;
+        size_t eq = pair.find('=');
+        out.push_back(QueryParam{url_decode(pair.substr(0, eq)),
+                                 eq == std::string_view::npos ? std::string() : url_decode(pair.substr(eq + 1))});
+    }
+    return out;
+}
+
+const std::string* find_param(const std::vector<QueryParam>& params, std::string_view name) {
+    for (const auto& p : params) if (p.name == name) return &p.value;
+    return nullptr;
+}
+
+std::string_view Response::header(std::string_view name) const { return find_header(headers, name); }
+bool Response::keep_alive() const { return wants_keep_alive(version, header("connection")); }
+
+Status Parser::fail(int status, const char* why) {
+    state_ = State::Failed;
+    error_status_ = status;
+    error_ = why;
+    return Status::Error;
+}
+
+void Parser::reset() {
+    state_ = State::Head;
+    pos_ = 0;
+    scan_ = 0;
+    head_end_ = 0;
+    body_len_ = 0;
+    chunk_left_ = 0;
+    chunked_ = false;
+    until_eof_ = false;
+    header_spans_.clear();
+    chunked_body_.clear();
+    req_.headers.clear();
+    req_.method = req_.target = req_.version = req_.body = {};
+    resp_.headers.clear();
+    resp_.version = resp_.reason = resp_.body = {};
+    resp_.status = 0;
+    error_status_ = 400;
+    error_.clear();
+}
+
+Status Parser::parse_head(std::string_view buf) {
+    size_t from = scan_ > pos_ + 3 ? scan_ - 3 : pos_;
+    size_t e = buf.find("\r\n\r\n", from);
+    if (e == std::string_view::npos) {
+        scan_ = buf.size();
+        if (buf.size() - pos_ > kMaxHeaderBytes) return fail(400, "header terlalu besar");
+        return Status::Incomplete;
+    }
+    if (e - pos_ > kMaxHeaderBytes) return fail(400, "header terlalu besar");
+
+    auto span = [&](size_t off, size_t len) { return Span{(uint32_t)off, (uint32_t)len}; };
+
+    // Request line: METHOD SP target SP version
+    // Status line:  version SP status SP reason (reason may be empty)
+    size_t line_end = buf.find("\r\n", pos_);
+    std::string_view line = buf.substr(pos_, line_end - pos_);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+    if (kind_ == Kind::Response && sp1 != std::string_view::npos && sp2 == std::string_view::npos) {
+        sp2 = line.size();
+    }
+    if (sp1 == 0 || sp1 == std::string_view::npos || sp2 == std::string_view::npos || sp2 == sp1 + 1) {
+        return fail(400, "start line tidak valid");
+    }
+    method_ = span(pos_, sp1);
+    target_ = span(pos_ + sp1 + 1, sp2 - sp1 - 1);
+    version_ = sp2 < line.size() ? span(pos_ + sp2 + 1, line.size() - sp2 - 1) : span(pos_ + line.size(), 0);
+
+    body_len_ = 0;
+    chunked_ = false;
+    bool have_length = false;
+    size_t p = line_end + 2;
+    while (p < e + 2) {
+        size_t le = buf.find("\r\n", p);
+        std::string_view hl = buf.substr(p, le - p);
+        size_t colon = hl.find(':');
+        // Also rejects obsolete line folding, whose continuation starts with whitespace.
+        if (colon == std::string_view::npos || colon == 0 || hl[0] == ' ' || hl[0] == '\t') {
+            return fail(400, "header tidak valid");
+        }
+        std::string_view name = hl.substr(0, colon);
+        std::string_view value = trim(hl.substr(colon + 1));
+        header_spans_.push_back({span(p, colon), span((size_t)(value.data() - buf.data()), value.size())});
+        if (iequals(name, "transfer-encoding") && icontains(value, "chunked")) {
+            chunked_ = true;
+        } else if (iequals(name, "content-length")) {
+            size_t n = 0;
+            auto r = std::from_chars(value.data(), value.data() + value.size(), n);
+            if (r.ec != std::errc() || r.ptr != value.data() + value.size()) {
+                return fail(400, "Content-Length tidak valid");
+            }
+            if (have_length && n != body_len_) return fail(400, "Content-Length ganda");
+            body_len_ = n;
+            have_length = true;
+        }
+        p = le + 2;
+    }
+
+    if (!chunked_ && body_len_ > kMaxBodyBytes) return fail(413, "body terlalu besar");
+
+    if (kind_ == Kind::Response) {
+        std::string_view code = buf.substr(target_.off, target_.len);
+        int status = 0;
+        auto r = std::from_chars(code.data(), code.data() + code.size(), status);
+        if (r.ec != std::errc() || status < 100 || status > 999) return fail(400, "status code tidak valid");
+        // 1xx, 204 and 304 never carry a body; otherwise no framing means read to EOF.
+        bool bodyless = status < 200 || status == 204 || status == 304;
+        until_eof_ = !chunked_ && !have_length && !bodyless;
+    }
+
+    head_end_ = e + 4;
+    pos_ = head_end_;
+    state_ = chunked_ ? State::ChunkSize : State::Body;
+    return Status::Incomplete;
+}
+
+void Parser::finish(std::string_view buf) {
+    auto view = [&](Span s) { return buf.substr(s.off, s.len); };
+    std::string_view body = chunked_ ? std::string_view(chunked_body_) : buf.substr(head_end_, body_len_);
+    if (kind_ == Kind::Request) {
+        req_.method = view(method_);
+        req_.target = view(target_);
+        req_.version = view(version_);
+        req_.headers.clear();
+        for (const auto& h : header_spans_) req_.headers.push_back({view(h.name), view(h.value)});
+        req_.body = body;
+    } else {
+        resp_.version = view(method_);
+        std::string_view code = view(target_);
+        std::from_chars(code.data(), code.data() + code.size(), resp_.status);
+        resp_.reason = view(version_);
+        resp_.headers.clear();
+        for (const auto& h : header_spans_) resp_.headers.push_back({view(h.name), view(h.value)});
+        resp_.body = body;
+    }
+    state_ = State::Done;
+}
+
+Status Parser::finish_at_eof(std::string_view buf) {
+    Status s = parse(buf);
+    if (s != Status::Incomplete) return s;
+    if (state_ != State::Body || !until_eof_) return fail(400, "koneksi ditutup sebelum pesan lengkap");
+    body_len_ = buf.size() - head_end_;
+    pos_ = buf.size();
+    finish(buf);
+    return Status::Complete;
+}
+
+Status Parser::parse(std::string_view buf) {
+    while (true) {
+        switch (state_) {
+        case State::Done:
+            return Status::Complete;
+        case State::Failed:
+            return Status::Error;
+        case State::Head: {
+            Status s = parse_head(buf);
+            if (state_ == State::Head || s == Status::Error) return s;
+            break;
+        }
+        case State::Body:
+            if (until_eof_) {
+                if (buf.size() - head_end_ > kMaxBodyBytes) return fail(413, "body terlalu besar");
+                return Status::Incomplete;
+            }
+            if (buf.size() - pos_ < body_len_) return Status::Incomplete;
+            pos_ += body_len_;
+            finish(buf);
+            return Status::Complete;
+        case State::ChunkSize: {
+            size_t le = buf.find("\r\n", pos_);
+            if (le == std::string_view::npos) {
+                if (buf.size() - pos_ > 1024) return fail(400, "chunk header tidak valid");
+                return Status::Incomplete;
+            }
+            std::string_view hex = buf.substr(pos_, le - pos_);
+            size_t semi = hex.find(';');
+            if (semi != std::string_view::npos) hex = hex.substr(0, semi);
+            hex = trim(hex);
+            size_t n = 0;
+            auto r = std::from_chars(hex.data(), hex.data() + hex.size(), n, 16);
+            if (hex.empty() || r.ec != std::errc() || r.ptr != hex.data() + hex.size()) {
+                return fail(400, "chunk size tidak valid");
+            }
+            if (chunked_body_.size() + n > kMaxBodyBytes) return fail(413, "body terlalu besar");
+            pos_ = le + 2;
+            chunk_left_ = n;
+            state_ = n == 0 ? State::Trailers : State::ChunkData;
+            break;
+        }
+        case State::ChunkData: {
+            size_t avail = buf.size() - pos_;
+            size_t take = avail < chunk_left_ ? avail : chunk_left_;
+            chunked_body_.append(buf.data() + pos_, take);
+            pos_ += take;
+            chunk_left_ -= take;
+            if (chunk_left_ > 0 || buf.size() - pos_ < 2) return Status::Incomplete;
+            if (buf[pos_] != '\r' || buf[pos_ + 1] != '\n') return fail(400, "chunk tidak diakhiri CRLF");
+            pos_ += 2;
+            state_ = State::ChunkSize;
+            break;
+        }
+        case State::Trailers: {
+            size_t le = buf.find("\r\n", pos_);
+            if (le == std::string_view::npos) {
+                if (buf.size() - pos_ > kMaxHeaderBytes) return fail(400, "trailer terlalu besar");
+                return Status::Incomplete;
+            }
+            bool last = le == pos_;
+            pos_ = le + 2;
+            if (last) {
+                finish(buf);
+                return Status::Complete;
+            }
+            break;
+        }
+        }
+    }
+}
+
+} // namespace httpparser
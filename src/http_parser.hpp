@@ -0,0 +1,117 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace httpparser {
+
+struct Header {
+    std::string_view name;
+    std::string_view value;
+};
+
+// A parsed request. All views point into the buffer handed to Parser::parse
+// (or, for chunked bodies, into the parser's decode buffer) and stay valid
+// until that buffer is modified or the parser is reset.
+struct Request {
+    std::string_view method;
+    std::string_view target;
+    std::string_view version;
+    std::vector<Header> headers;
+    std::string_view body;
+
+    // Case-insensitive lookup; empty view when absent.
+    std::string_view header(std::string_view name) const;
+    // HTTP/1.1 defaults to a persistent connection, HTTP/1.0 to close.
+    bool keep_alive() const;
+    // The target split at the first '?' (query without it).
+    std::string_view path() const;
+    std::string_view query() const;
+};
+
+// A parsed response (Parser constructed with Kind::Response), same lifetime
+// rules as Request.
+struct Response {
+    std::string_view version;
+    int status = 0;
+    std::string_view reason;
+    std::vector<Header> headers;
+    std::string_view body;
+
+    std::string_view header(std::string_view name) const;
+    bool keep_alive() const;
+};
+
+struct QueryParam {
+    std::string name;
+    std::string value;
+};
+
+// Decodes an application/x-www-form-urlencoded query string ('+' and %XX
+// escapes). Pairs keep their order and repeats; a name without '=' gets an
+// empty value.
+std::vector<QueryParam> parse_query(std::string_view query);
+// Value of the first parameter called name, or nullptr.
+const std::string* find_param(const std::vector<QueryParam>& params, std::string_view name);
+
+enum class Status { Incomplete, Complete, Error };
+enum class Kind { Request, Response };
+
+// Incremental HTTP/1.x parser. Call parse() with the whole per-connection
+// buffer (starting at the current message) each time more bytes arrive;
+// scanning resumes where the previous call stopped, and framing follows
+// Content-Length or Transfer-Encoding: chunked so reading can stop exactly at
+// the end of the message. Responses without either are delimited by EOF; see
+// finish_at_eof().
+class Parser {
+public:
+    explicit Parser(Kind kind = Kind::Request): kind_(kind) {}
+
+    static constexpr size_t kMaxHeaderBytes = 64 * 1024;
+    static constexpr size_t kMaxBodyBytes = 4 * 1024 * 1024;
+
+    Status parse(std::string_view buf);
+    // Completes an EOF-delimited response body once the peer has closed.
+    Status finish_at_eof(std::string_view buf);
+    void reset();
+
+    const Request& request() const { return req_; }
+    const Response& response() const { return resp_; }
+    // Bytes of the buffer taken by the completed request (start of the next
+    // pipelined request).
+    size_t consumed() const { return pos_; }
+    // HTTP status suggested for an Error result (400 or 413).
+    int error_status() const { return error_status_; }
+    const std::string& error() const { return error_; }
+
+private:
+    enum class State { Head, Body, ChunkSize, ChunkData, Trailers, Done, Failed };
+    struct Span { uint32_t off = 0, len = 0; };
+    struct HeaderSpan { Span name, value; };
+
+    Status fail(int status, const char* why);
+    Status parse_head(std::string_view buf);
+    void finish(std::string_view buf);
+
+    Kind kind_;
+    State state_ = State::Head;
+    size_t pos_ = 0;
+    size_t scan_ = 0;
+    size_t head_end_ = 0;
+    size_t body_len_ = 0;
+    size_t chunk_left_ = 0;
+    Span method_, target_, version_;
+    std::vector<HeaderSpan> header_spans_;
+    std::string chunked_body_;
+    bool chunked_ = false;
+    bool until_eof_ = false;
+
+    Request req_;
+    Response resp_;
+    int error_status_ = 400;
+    std::string error_;
+};
+
+} // namespace httpparser
@@ -3,10 +3,27 @@
 #include "file_store.hpp"
 #include "logger.hpp"
 #include "inventory.hpp"
+#include "asset_index.hpp"
+#include "asset_query.hpp"
+#include "http_parser.hpp"
+#include "metrics.hpp"
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <vector>
 #include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <cstdio>
 
 #ifdef _WIN32
   #ifndef WIN32_LEAN_AND_MEAN
@@ -20,6 +37,16 @@
   #include <netinet/in.h>
   #include <unistd.h>
 #endif
+#ifdef __linux__
+  #include <sys/epoll.h>
+  #include <sys/eventfd.h>
+  #include <sys/uio.h>
+  #include <fcntl.h>
+  #include <cerrno>
+#endif
+#ifdef ASSET_INVENTORY_HAVE_ZLIB
+  #include <zlib.h>
+#endif
 
 static void sock_close(int fd) {
 #ifdef _WIN32
@@ -45,6 +72,7 @@ static void sock_cleanup() {
 }
 
 static bool send_all(int fd, const std::string& data) {
+    metrics::Timer timer(metrics::Stage::Send);
     const char* p = data.c_str();
     size_t left = data.size();
     while (left > 0) {
@@ -60,62 +88,23 @@ static bool send_all(int fd, const std::string& data) {
     return true;
 }
 
-static std::string read_request(int fd) {
-    std::string data;
-    char buf[4096];
+// Reads exactly one request: stops as soon as the parser has seen the end of
+// the headers and the Content-Length (or chunked) body.
+static httpparser::Status read_request(int fd, std::string& buf, httpparser::Parser& parser) {
+    size_t len = 0;
     for (;;) {
+        if (buf.size() < len + 4096) buf.resize(len + 16384);
 #ifdef _WIN32
-        int n = recv((SOCKET)fd, buf, (int)sizeof(buf), 0);
+        int n = recv((SOCKET)fd, &buf[len], (int)(buf.size() - len), 0);
 #else
-        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        ssize_t n = recv(fd, &buf[len], buf.size() - len, 0);
 #endif
         if (n <= 0) break;
-        data.append(buf, buf + n);
-        if (data.size() > 4*1024*1024) break;
-        // crude: stop if connection closes
-        if (data.find("\r\n\r\n") != std::string::npos) {
-            // may still need body; handled later by content-length
-        }
+        len += (size_t)n;
+        auto st = parser.parse(std::string_view(buf.data(), len));
+        if (st != httpparser::Status::Incomplete) return st;
     }
-    return data;
-}
-
-static bool parse_start_line(const std::string& req, std::string& method, std::string& path) {
-    auto end = req.find("\r\n");
-    if (end == std::string::npos) return false;
-    std::istringstream ss(req.substr(0, end));
-    ss >> method >> path;
-    return !method.empty() && !path.empty();
-}
-
-static std::string get_header(const std::string& req, const std::string& key) {
-    std::string k = key;
-    std::transform(k.begin(), k.end(), k.begin(), [](unsigned char c){ return (char)std::tolower(c); });
-
-    auto head_end = req.find("\r\n\r\n");
-    if (head_end == std::string::npos) return "";
-    std::string head = req.substr(0, head_end);
-
-    std::istringstream ss(head);
-    std::string line;
-    std::getline(ss, line); // start line
-    while (std::getline(ss, line)) {
-        if (!line.empty() && line.back()=='\r') line.pop_back();
-        auto pos = line.find(':');
-        if (pos == std::string::npos) continue;
-        std::string hk = line.substr(0, pos);
-        std::string hv = line.substr(pos + 1);
-        while (!hv.empty() && hv.front()==' ') hv.erase(hv.begin());
-        std::transform(hk.begin(), hk.end(), hk.begin(), [](unsigned char c){ return (char)std::tolower(c); });
-        if (hk == k) return hv;
-    }
-    return "";
-}
-
-static std::string get_body(const std::string& req) {
-    auto sep = req.find("\r\n\r\n");
-    if (sep == std::string::npos) return "";
-    return req.substr(sep + 4);
+    return httpparser::Status::Incomplete;
 }
 
 static std::string html_dashboard() {
@@ -137,7 +126,13 @@ static std::string html_dashboard() {
 </head>
 <body>
   <h1>Asset Inventory Dashboard <span class="pill">local</span></h1>
-  <div class="meta">Endpoint: <code>/api/assets</code> • Export: <code>/export.csv</code></div>
+  <div class="meta">Endpoint: <code>/api/assets</code> • Export: <code>/export.csv</code> • Stats: <code>/api/stats</code></div>
+  <form id="filter" class="meta">
+    <input name="hostname_prefix" placeholder="hostname prefix"/>
+    <input name="os" placeholder="os"/>
+    <input name="low_disk_gb" placeholder="free disk &lt; GB" size="8"/>
+    <button>Filter</button>
+  </form>
   <table>
     <thead>
       <tr>
@@ -152,14 +147,23 @@ static std::string html_dashboard() {
     </thead>
     <tbody id="rows"></tbody>
   </table>
+  <p><button id="more" hidden>Load more</button></p>
 
 <script>
-async function load(){
-  const r = await fetch('/api/assets');
-  const arr = await r.json();
+let next = null;
+function params(){
+  const q = new URLSearchParams({sort: '-timestamp_utc', limit: '200'});
+  for (const [k, v] of new FormData(document.getElementById('filter'))) if (v) q.set(k, v);
+  return q;
+}
+async function load(cursor){
+  const q = params();
+  if (cursor) q.set('cursor', cursor);
+  const r = await fetch('/api/assets?' + q);
+  const page = await r.json();
   const tbody = document.getElementById('rows');
-  tbody.innerHTML = '';
-  for (const a of arr){
+  if (!cursor) tbody.innerHTML = '';
+  for (const a of page.items || []){
     const disks = (a.disks||[]).map(d => `${d.mount}:${d.total_gb}/${d.free_gb}`).join(' | ');
     const tr = document.createElement('tr');
     tr.innerHTML = `
@@ -172,103 +176,771 @@ async function load(){
       <td>${a.timestamp_utc||''}</td>`;
     tbody.appendChild(tr);
   }
+  next = page.next_cursor;
+  document.getElementById('more').hidden = !next;
 }
-load();
+document.getElementById('filter').onsubmit = e => { e.preventDefault(); load(null); };
+document.getElementById('more').onclick = () => load(next);
+load(null);
 </script>
 </body>
 </html>)";
 }
 
-static std::string http_response(int status, const std::string& content_type, const std::string& body) {
+static std::string http_response(int status, const std::string& content_type, const std::string& body,
+                                 bool keep_alive = false) {
     std::ostringstream o;
     o << "HTTP/1.1 " << status << " ";
     if (status==200) o << "OK";
     else if (status==201) o << "Created";
+    else if (status==304) o << "Not Modified";
     else if (status==400) o << "Bad Request";
     else if (status==404) o << "Not Found";
+    else if (status==409) o << "Conflict";
+    else if (status==413) o << "Payload Too Large";
+    else if (status==500) o << "Internal Server Error";
     else o << "Error";
     o << "\r\n";
     o << "Content-Type: " << content_type << "\r\n";
-    o << "Connection: close\r\n";
+    o << (keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
     o << "Content-Length: " << body.size() << "\r\n\r\n";
     o << body;
     return o.str();
 }
 
-static std::string json_array_from_store() {
-    auto lines = filestore::read_lines("data/assets.jsonl");
-    std::vector<minijson::Value> items;
-    for (const auto& ln : lines) {
+// Produces a response body piece by piece. The reactor asks for the next
+// piece only once the connection's queued output has drained, so a slow
+// client holds at most a few pieces in memory.
+class BodyStream {
+public:
+    virtual ~BodyStream() = default;
+    // Appends the next piece (possibly empty) to out; false once the body is
+    // complete.
+    virtual bool next(std::string& out) = 0;
+};
+
+struct StoreOp;
+
+struct Reply {
+    Reply() = default;
+    explicit Reply(std::string response) : head(std::move(response)) {}
+
+    std::string head; // status line and headers, plus the body when not shared
+    std::shared_ptr<const std::string> body{};
+    std::unique_ptr<BodyStream> stream{}; // sent after body, already framed for the wire
+    bool close_after = false;             // body is delimited by closing the connection
+    // Set instead of head by POSTs: the records still have to be stored, and
+    // the real reply comes from store->finish once they are.
+    std::shared_ptr<StoreOp> store{};
+};
+
+// A POST's validated records on their way to the store. finish indexes the
+// lines that were stored (result.positions, a prefix of lines) and builds
+// the reply. The op owns everything finish needs: the request buffer may be
+// reused before the append completes.
+struct StoreOp {
+    std::vector<std::string> lines;
+    std::function<Reply(const filestore::AppendResult&)> finish;
+    metrics::Route route = metrics::Route::Other;
+    uint64_t started_ns = 0; // for the Append stage
+};
+
+static const char* const kStorePath = "data/assets.jsonl";
+
+// Latest record per asset, built from the store at startup and updated on
+// every accepted POST. g_store_mu guards it (shared for GETs, exclusive for
+// POSTs); g_generation is bumped under the exclusive lock whenever the index
+// changes. Appends go through g_writer, which batches concurrent records.
+static std::unique_ptr<filestore::AppendWriter> g_writer;
+static std::shared_mutex g_store_mu;
+static assetindex::AssetIndex g_index;
+static uint64_t g_generation = 0;
+// Assets with a delta between its version check and its index update.
+static std::unordered_set<std::string> g_delta_pending;
+
+// Fully rendered GET body plus its pre-built headers, valid for one store
+// generation and rebuilt lazily by the first request that sees a newer one.
+struct CachedBody {
+    bool valid = false;
+    uint64_t generation = 0;
+    std::string etag;
+    std::string head; // status line .. Content-Length, without Connection and the blank line
+    std::shared_ptr<const std::string> body;
+};
+
+enum class CachedRoute { AssetsJson, ExportCsv };
+
+static std::mutex g_cache_mu;
+static CachedBody g_cache[2];
+
+static std::string make_etag(const std::string& body) {
+    // FNV-1a; changes whenever the content does, and survives restarts
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : body) { h ^= c; h *= 1099511628211ULL; }
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "\"%016llx\"", (unsigned long long)h);
+    return buf;
+}
+
+static CachedBody cached_body(CachedRoute route) {
+    std::lock_guard<std::mutex> ck(g_cache_mu);
+    CachedBody& c = g_cache[(int)route];
+    std::shared_lock<std::shared_mutex> lk(g_store_mu);
+    if (c.valid && c.generation == g_generation) return c;
+
+    const char* content_type;
+    std::string body;
+    if (route == CachedRoute::AssetsJson) {
+        content_type = "application/json; charset=utf-8";
+        body = g_index.to_json_array(true);
+    } else {
+        content_type = "text/csv; charset=utf-8";
+        body = g_index.to_csv();
+    }
+    c.generation = g_generation;
+    lk.unlock();
+
+    c.etag = make_etag(body);
+    c.head = "HTTP/1.1 200 OK\r\nContent-Type: ";
+    c.head += content_type;
+    c.head += "\r\nETag: " + c.etag + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+    c.body = std::make_shared<const std::string>(std::move(body));
+    c.valid = true;
+    return c;
+}
+
+static bool etag_matches(std::string_view if_none_match, const std::string& etag) {
+    while (!if_none_match.empty()) {
+        size_t comma = if_none_match.find(',');
+        std::string_view tag = if_none_match.substr(0, comma);
+        while (!tag.empty() && tag.front() == ' ') tag.remove_prefix(1);
+        while (!tag.empty() && tag.back() == ' ') tag.remove_suffix(1);
+        if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+        if (tag == "*" || tag == etag) return true;
+        if (comma == std::string_view::npos) break;
+        if_none_match.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+static Reply cached_reply(CachedRoute route, const httpparser::Request& req, bool keep_alive) {
+    CachedBody c = cached_body(route);
+    const char* conn = keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    Reply r;
+    if (etag_matches(req.header("if-none-match"), c.etag)) {
+        r.head = "HTTP/1.1 304 Not Modified\r\nETag: " + c.etag + "\r\n" + conn;
+        return r;
+    }
+    r.head = c.head + conn;
+    r.body = std::move(c.body);
+    return r;
+}
+
+// Large GET bodies are streamed instead of cached once the fleet has this
+// many assets (set from Options by run()).
+static size_t g_stream_min_assets = 10000;
+static bool g_gzip = true;
+
+// Renders /api/assets (pretty JSON array, same text as to_json_array) or
+// /export.csv rows straight from the index, ~32 KB per piece. The store lock
+// is taken per piece, so rows stored while the response is in flight may
+// already show their new value, and rows added meanwhile are included.
+class AssetRowsStream : public BodyStream {
+public:
+    explicit AssetRowsStream(CachedRoute route): route_(route) {}
+
+    bool next(std::string& out) override {
+        const size_t target = out.size() + 32 * 1024;
+        if (row_ == 0 && route_ == CachedRoute::ExportCsv) out += assetindex::kCsvHeader;
+        if (row_ == 0 && route_ == CachedRoute::AssetsJson) out += '[';
+        std::shared_lock<std::shared_mutex> lk(g_store_mu);
+        const auto& entries = g_index.entries();
+        for (; row_ < entries.size() && out.size() < target; row_++) {
+            const auto& rec = entries[row_].record;
+            if (route_ == CachedRoute::ExportCsv) {
+                assetindex::append_csv_row(out, rec, g_index.strings());
+            } else {
+                out += row_ ? ",\n  " : "\n  ";
+                minijson::Writer w(out, true, 2);
+                assetindex::write_json(w, rec, g_index.strings());
+            }
+        }
+        if (row_ < entries.size()) return true;
+        if (route_ == CachedRoute::AssetsJson) out += row_ ? "\n]" : "]";
+        return false;
+    }
+
+private:
+    CachedRoute route_;
+    size_t row_ = 0;
+};
+
+// Wraps a body stream with optional gzip and HTTP/1.1 chunked framing.
+class EncodedStream : public BodyStream {
+public:
+    EncodedStream(std::unique_ptr<BodyStream> inner, bool gzip, bool chunked)
+        : inner_(std::move(inner)), chunked_(chunked) {
+#ifdef ASSET_INVENTORY_HAVE_ZLIB
+        // level 1: the reactor thread compresses, so favour speed
+        gzip_ = gzip && deflateInit2(&zs_, 1, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+#else
+        (void)gzip;
+#endif
+    }
+    ~EncodedStream() override {
+#ifdef ASSET_INVENTORY_HAVE_ZLIB
+        if (gzip_) deflateEnd(&zs_);
+#endif
+    }
+
+    bool next(std::string& out) override {
+        bool more = true;
+        // An empty chunk would end the body, so pull until there is output.
+        do {
+            raw_.clear();
+            more = inner_->next(raw_);
+            encoded_.clear();
+            if (gzip_) compress(more ? 0 : 1);
+            else encoded_.swap(raw_);
+        } while (encoded_.empty() && more);
+        if (!chunked_) {
+            out += encoded_;
+        } else {
+            if (!encoded_.empty()) {
+                char len[20];
+                std::snprintf(len, sizeof(len), "%zx\r\n", encoded_.size());
+                out += len;
+                out += encoded_;
+                out += "\r\n";
+            }
+            if (!more) out += "0\r\n\r\n";
+        }
+        return more;
+    }
+
+private:
+    void compress(int finish) {
+#ifdef ASSET_INVENTORY_HAVE_ZLIB
+        zs_.next_in = (Bytef*)raw_.data();
+        zs_.avail_in = (uInt)raw_.size();
+        int rc;
+        do {
+            size_t have = encoded_.size();
+            encoded_.resize(have + 16384);
+            zs_.next_out = (Bytef*)&encoded_[have];
+            zs_.avail_out = 16384;
+            rc = deflate(&zs_, finish ? Z_FINISH : Z_NO_FLUSH);
+            encoded_.resize(have + 16384 - zs_.avail_out);
+        } while (zs_.avail_out == 0 || (finish && rc == Z_OK));
+#else
+        (void)finish;
+#endif
+    }
+
+    std::unique_ptr<BodyStream> inner_;
+    bool chunked_;
+    bool gzip_ = false;
+    std::string raw_, encoded_;
+#ifdef ASSET_INVENTORY_HAVE_ZLIB
+    z_stream zs_{};
+#endif
+};
+
+static bool accepts_gzip(std::string_view accept_encoding) {
+#ifdef ASSET_INVENTORY_HAVE_ZLIB
+    while (!accept_encoding.empty()) {
+        size_t comma = accept_encoding.find(',');
+        std::string_view item = accept_encoding.substr(0, comma);
+        while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+        size_t semi = item.find(';');
+        std::string_view coding = item.substr(0, semi);
+        while (!coding.empty() && coding.back() == ' ') coding.remove_suffix(1);
+        if (coding == "gzip" || coding == "x-gzip") {
+            std::string_view params = semi == std::string_view::npos ? std::string_view() : item.substr(semi + 1);
+            size_t q = params.find("q=");
+            return q == std::string_view::npos || std::strtod(std::string(params.substr(q + 2)).c_str(), nullptr) > 0;
+        }
+        if (comma == std::string_view::npos) break;
+        accept_encoding.remove_prefix(comma + 1);
+    }
+#else
+    (void)accept_encoding;
+#endif
+    return false;
+}
+
+// Streamed counterpart of cached_reply. The body is never materialised, so
+// the ETag names the store generation (weak, as the gzip and identity
+// encodings share it); the boot time keeps tags from a previous run apart.
+static Reply streamed_reply(CachedRoute route, const httpparser::Request& req, bool keep_alive) {
+    static const long long boot = (long long)std::chrono::system_clock::now().time_since_epoch().count();
+    uint64_t generation;
+    {
+        std::shared_lock<std::shared_mutex> lk(g_store_mu);
+        generation = g_generation;
+    }
+    char etag[48];
+    std::snprintf(etag, sizeof(etag), "\"%llx-%llx\"", (unsigned long long)boot, (unsigned long long)generation);
+
+    const bool chunked = req.version == "HTTP/1.1";
+    const bool gzip = g_gzip && accepts_gzip(req.header("accept-encoding"));
+    Reply r;
+    if (etag_matches(req.header("if-none-match"), etag)) {
+        r.head = std::string("HTTP/1.1 304 Not Modified\r\nETag: W/") + etag + "\r\n" +
+                 (keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n");
+        return r;
+    }
+    r.head = "HTTP/1.1 200 OK\r\nContent-Type: ";
+    r.head += route == CachedRoute::AssetsJson ? "application/json; charset=utf-8" : "text/csv; charset=utf-8";
+    r.head += std::string("\r\nETag: W/") + etag + "\r\n";
+    if (gzip) r.head += "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n";
+    if (chunked) r.head += "Transfer-Encoding: chunked\r\n";
+    // Without chunked framing the end of the body is the end of the connection.
+    r.close_after = !chunked;
+    r.head += keep_alive && chunked ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    r.stream = std::make_unique<EncodedStream>(std::make_unique<AssetRowsStream>(route), gzip, chunked);
+    return r;
+}
+
+// Full-list GETs: cached while the fleet is small, streamed beyond that.
+static Reply list_reply(CachedRoute route, const httpparser::Request& req, bool keep_alive) {
+    size_t assets;
+    {
+        std::shared_lock<std::shared_mutex> lk(g_store_mu);
+        assets = g_index.size();
+    }
+    if (assets >= g_stream_min_assets) return streamed_reply(route, req, keep_alive);
+    return cached_reply(route, req, keep_alive);
+}
+
+// Comma-separated query value; empty items are skipped.
+static void split_list(std::string_view s, std::vector<std::string>& out) {
+    while (!s.empty()) {
+        size_t comma = s.find(',');
+        std::string_view item = s.substr(0, comma);
+        if (!item.empty()) out.emplace_back(item);
+        if (comma == std::string_view::npos) break;
+        s.remove_prefix(comma + 1);
+    }
+}
+
+// GET /api/stats?group_by=os&metrics=ram_total_mb,cpu_cores
+// Aggregates are computed from the index's column table on every request;
+// at fleet sizes they take a few milliseconds, cheaper than caching per
+// parameter combination.
+static bool stats_body(std::string_view query, std::string& body, std::string& err) {
+    assetindex::StatsQuery q;
+    for (const auto& p : httpparser::parse_query(query)) {
+        if (p.name == "group_by") {
+            q.group_by = p.value;
+        } else if (p.name == "metrics") {
+            split_list(p.value, q.metrics);
+        } else {
+            err = "parameter tidak dikenal: " + p.name;
+            return false;
+        }
+    }
+    std::shared_lock<std::shared_mutex> lk(g_store_mu);
+    return assetindex::stats_json(g_index.columns(), g_index.strings(), q, body, err);
+}
+
+// GET /api/assets?hostname_prefix=..&os=..&since=..&until=..&low_disk_gb=..
+//                &fields=a,b&sort=-timestamp_utc&limit=100&cursor=..
+static bool assets_query_body(std::string_view query, std::string& body, std::string& err) {
+    assetindex::AssetQuery q;
+    for (const auto& p : httpparser::parse_query(query)) {
+        if (p.name == "hostname_prefix") q.hostname_prefix = p.value;
+        else if (p.name == "os") q.os = p.value;
+        else if (p.name == "since") q.since = p.value;
+        else if (p.name == "until") q.until = p.value;
+        else if (p.name == "sort") q.sort = p.value;
+        else if (p.name == "cursor") q.cursor = p.value;
+        else if (p.name == "fields") split_list(p.value, q.fields);
+        else if (p.name == "low_disk_gb" || p.name == "limit") {
+            char* end = nullptr;
+            double d = std::strtod(p.value.c_str(), &end);
+            if (p.value.empty() || *end || !(d >= 0)) {
+                err = p.name + " harus angka >= 0";
+                return false;
+            }
+            if (p.name == "limit") {
+                if (d < 1 || d > assetindex::kMaxQueryLimit) {
+                    err = "limit harus 1.." + std::to_string(assetindex::kMaxQueryLimit);
+                    return false;
+                }
+                q.limit = (size_t)d;
+            } else {
+                q.low_disk_gb = d;
+            }
+        } else {
+            err = "parameter tidak dikenal: " + p.name;
+            return false;
+        }
+    }
+    std::shared_lock<std::shared_mutex> lk(g_store_mu);
+    return assetindex::query_json(g_index, q, body, err);
+}
+
+static Reply bad_query(const std::string& err, bool keep_alive) {
+    std::string body;
+    minijson::Writer w(body);
+    w.start_object();
+    w.key("ok"); w.boolean(false);
+    w.key("error"); w.string("bad_query");
+    w.key("detail"); w.string(err);
+    w.end_object();
+    return Reply(http_response(400, "application/json; charset=utf-8", body, keep_alive));
+}
+
+// Reply whose body is produced once its records are stored.
+static Reply deferred(std::shared_ptr<StoreOp> op) {
+    Reply r;
+    r.store = std::move(op);
+    return r;
+}
+
+// POST /api/assets/batch: a JSON array of records, or NDJSON (one record
+// per line). Items are validated one by one; the valid ones are appended with
+// a single write and indexed under one lock. results[i] is true for a stored
+// item, otherwise {"error":..,"detail":..}; a write that fails part-way
+// reports store_failed for the items after the last stored one.
+static Reply batch_ingest(std::string_view body, bool keep_alive) {
+    auto json = [keep_alive](int status, const std::string& b) {
+        return Reply(http_response(status, "application/json; charset=utf-8", b, keep_alive));
+    };
+    struct Rejected { size_t index; const char* error; std::string detail; };
+    struct Batch {
+        std::string body;
+        std::deque<minijson::Document> docs; // stable addresses for `accepted`
+        std::vector<const minijson::Node*> accepted;
+        std::vector<size_t> accepted_index; // item number of each accepted record
+        std::vector<Rejected> rejected;
+        size_t items = 0;
+    };
+    auto b = std::make_shared<Batch>();
+    b->body.assign(body.data(), body.size());
+    body = b->body;
+    auto op = std::make_shared<StoreOp>();
+
+    auto take = [&](const minijson::Node& v) {
+        std::string why;
+        metrics::Timer validate_timer(metrics::Stage::Validate);
+        bool valid = inventory::validate_asset_schema(v, why);
+        validate_timer.stop();
+        if (!valid) {
+            b->rejected.push_back(Rejected{b->items++, "schema_invalid", why});
+            return false;
+        }
+        b->accepted.push_back(&v);
+        b->accepted_index.push_back(b->items++);
+        op->lines.push_back(minijson::stringify(v, false));
+        return true;
+    };
+
+    size_t first = body.find_first_not_of(" \t\r\n");
+    if (first != std::string_view::npos && body[first] == '[') {
         try {
-            items.push_back(minijson::parse(ln));
-        } catch (...) {}
+            metrics::Timer parse_timer(metrics::Stage::JsonParse);
+            b->docs.push_back(minijson::Document::parse(body));
+        } catch (const std::exception& e) {
+            return json(400, std::string("{\"ok\":false,\"error\":\"invalid_json\",\"detail\":\"") + e.what() + "\"}");
+        }
+        for (const auto& v : b->docs.back().root()) take(v);
+    } else {
+        while (!body.empty()) {
+            size_t nl = body.find('\n');
+            std::string_view line = body.substr(0, nl);
+            body = nl == std::string_view::npos ? std::string_view() : body.substr(nl + 1);
+            while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) line.remove_suffix(1);
+            if (line.find_first_not_of(" \t") == std::string_view::npos) continue;
+            try {
+                metrics::Timer parse_timer(metrics::Stage::JsonParse);
+                b->docs.push_back(minijson::Document::parse(line));
+            } catch (const std::exception& e) {
+                b->rejected.push_back(Rejected{b->items++, "invalid_json", e.what()});
+                continue;
+            }
+            if (!take(b->docs.back().root())) b->docs.pop_back();
+        }
     }
-    minijson::Value root = minijson::Value::array(std::move(items));
-    return minijson::stringify(root, true);
+
+    op->finish = [b, json](const filestore::AppendResult& res) {
+        const size_t stored = res.positions.size();
+        if (!res.error.empty()) logutil::error("server", res.error);
+        if (stored == 0 && !b->accepted.empty()) return json(500, "{\"ok\":false,\"error\":\"store_failed\"}");
+        if (stored) {
+            std::unique_lock<std::shared_mutex> lk(g_store_mu);
+            for (size_t i=0;i<stored;i++) g_index.upsert(*b->accepted[i], res.positions[i]);
+            g_generation++;
+        }
+        if (stored < b->accepted.size()) {
+            for (size_t i=stored;i<b->accepted.size();i++) {
+                b->rejected.push_back(Rejected{b->accepted_index[i], "store_failed", res.error});
+            }
+            std::sort(b->rejected.begin(), b->rejected.end(),
+                      [](const Rejected& x, const Rejected& y) { return x.index < y.index; });
+        }
+
+        std::string out;
+        minijson::Writer w(out);
+        w.start_object();
+        w.key("ok"); w.boolean(b->rejected.empty());
+        w.key("accepted"); w.number((double)stored);
+        w.key("rejected"); w.number((double)b->rejected.size());
+        w.key("results");
+        w.start_array();
+        size_t r = 0;
+        for (size_t i=0;i<b->items;i++) {
+            if (r < b->rejected.size() && b->rejected[r].index == i) {
+                w.start_object();
+                w.key("error"); w.string(b->rejected[r].error);
+                w.key("detail"); w.string(b->rejected[r].detail);
+                w.end_object();
+                r++;
+            } else {
+                w.boolean(true);
+            }
+        }
+        w.end_array();
+        w.end_object();
+        return json(200, out);
+    };
+    return deferred(std::move(op));
 }
 
-static std::string csv_from_store() {
-    auto lines = filestore::read_lines("data/assets.jsonl");
-    std::ostringstream o;
-    o << "asset_id,hostname,os,cpu_model,cpu_cores,ram_total_mb,timestamp_utc,disks\n";
-    for (const auto& ln : lines) {
+// POST /api/assets/delta: {"asset_id","timestamp_utc","base",["set"],["unset"]}
+// from an agent whose last acknowledged payload had version `base`. The
+// version check, and the store that follows it, happen under the exclusive
+// lock with the asset reserved in g_delta_pending until the merged record is
+// indexed, so two deltas against the same base cannot both be accepted.
+// A delta that does not match the server's latest record (or arrives while
+// another one for the asset is being stored) gets 409 and the current version
+// (null if the asset is unknown); the agent then resends the full payload.
+//
+// The merged record is stored like a full POST, heartbeats (no set/unset,
+// so only timestamp_utc changes) included: store lines stay self-contained,
+// so loading, compaction and conversion see the same latest state.
+static Reply delta_ingest(std::string_view body, bool keep_alive) {
+    auto json = [keep_alive](int status, const std::string& b) {
+        return Reply(http_response(status, "application/json; charset=utf-8", b, keep_alive));
+    };
+    auto versioned = [json](int status, bool ok, const char* error, const std::string* version) {
+        std::string out;
+        minijson::Writer w(out);
+        w.start_object();
+        w.key("ok"); w.boolean(ok);
+        if (error) { w.key("error"); w.string(error); }
+        w.key("version");
+        if (version) w.string(*version); else w.null_value();
+        w.end_object();
+        return json(status, out);
+    };
+    auto failed = [json](int status, const char* error, std::string_view detail) {
+        std::string out;
+        minijson::Writer w(out);
+        w.start_object();
+        w.key("ok"); w.boolean(false);
+        w.key("error"); w.string(error);
+        if (!detail.empty()) { w.key("detail"); w.string(detail); }
+        w.end_object();
+        return json(status, out);
+    };
+
+    minijson::Document doc;
+    try {
+        metrics::Timer parse_timer(metrics::Stage::JsonParse);
+        doc = minijson::Document::parse(body);
+    } catch (const std::exception& e) {
+        return failed(400, "invalid_json", e.what());
+    }
+    const auto& delta = doc.root();
+    for (const char* k : {"asset_id", "base", "timestamp_utc"}) {
+        if (!delta.is_object() || !delta.has(k) || !delta.at(k).is_string()) {
+            return failed(400, "schema_invalid", std::string("field string wajib: ") + k);
+        }
+    }
+    std::string id(delta.at("asset_id").string());
+
+    auto record = std::make_shared<minijson::Value>();
+    std::string version;
+    {
+        std::unique_lock<std::shared_mutex> lk(g_store_mu);
+        const auto* e = g_index.find(id);
+        if (!e) return versioned(409, false, "version_mismatch", nullptr);
+        *record = assetindex::to_value(e->record, g_index.strings());
+        version = inventory::payload_version(*record);
+        if (version != delta.at("base").string() || g_delta_pending.count(id)) {
+            return versioned(409, false, "version_mismatch", &version);
+        }
+
+        std::string why;
+        metrics::Timer validate_timer(metrics::Stage::Validate);
+        bool valid = inventory::apply_delta(*record, delta, why) && inventory::validate_asset_schema(*record, why);
+        validate_timer.stop();
+        if (!valid) return failed(400, "schema_invalid", why);
+        g_delta_pending.insert(id);
+    }
+
+    auto op = std::make_shared<StoreOp>();
+    op->lines.push_back(minijson::stringify(*record, false));
+    version = inventory::payload_version(*record);
+    op->finish = [record, id, version, failed, versioned](const filestore::AppendResult& res) {
+        {
+            std::unique_lock<std::shared_mutex> lk(g_store_mu);
+            g_delta_pending.erase(id);
+            if (res.error.empty()) {
+                g_index.upsert(*record, res.positions[0]);
+                g_generation++;
+            }
+        }
+        if (!res.error.empty()) {
+            logutil::error("server", res.error);
+            return failed(500, "store_failed", {});
+        }
+        return versioned(200, true, nullptr, &version);
+    };
+    return deferred(std::move(op));
+}
+
+static Reply route_request(const httpparser::Request& req, bool keep_alive, metrics::Route& route) {
+    auto reply = [keep_alive](int status, const char* content_type, const std::string& body) {
+        return Reply(http_response(status, content_type, body, keep_alive));
+    };
+    const std::string_view method = req.method;
+    const std::string_view path = req.path();
+
+    if (method == "GET" && path == "/") {
+        route = metrics::Route::Dashboard;
+        return reply(200, "text/html; charset=utf-8", html_dashboard());
+    } else if (method == "GET" && path == "/api/assets") {
+        // Without parameters: the whole list, as before.
+        route = metrics::Route::Assets;
+        if (req.query().empty()) return list_reply(CachedRoute::AssetsJson, req, keep_alive);
+        route = metrics::Route::AssetsQuery;
+        std::string body, err;
+        if (!assets_query_body(req.query(), body, err)) return bad_query(err, keep_alive);
+        return reply(200, "application/json; charset=utf-8", body);
+    } else if (method == "GET" && path == "/export.csv") {
+        route = metrics::Route::ExportCsv;
+        return list_reply(CachedRoute::ExportCsv, req, keep_alive);
+    } else if (method == "GET" && path == "/api/stats") {
+        route = metrics::Route::Stats;
+        std::string body, err;
+        if (!stats_body(req.query(), body, err)) return bad_query(err, keep_alive);
+        return reply(200, "application/json; charset=utf-8", body);
+    } else if (method == "GET" && path == "/metrics") {
+        route = metrics::Route::Metrics;
+        return reply(200, "text/plain; version=0.0.4; charset=utf-8", metrics::render());
+    } else if (method == "POST" && path == "/api/assets/delta") {
+        route = metrics::Route::Delta;
+        return delta_ingest(req.body, keep_alive);
+    } else if (method == "POST" && path == "/api/assets/batch") {
+        route = metrics::Route::Batch;
+        return batch_ingest(req.body, keep_alive);
+    } else if (method == "POST" && path == "/api/assets") {
+        route = metrics::Route::Post;
+        // The document points into the body, which the op keeps.
+        struct Post { std::string body; minijson::Document doc; };
+        auto p = std::make_shared<Post>();
+        p->body.assign(req.body.data(), req.body.size());
         try {
-            auto v = minijson::parse(ln);
-            std::string disks;
-            if (v.has("disks") && v.at("disks").is_array()) {
-                for (size_t i=0;i<v.at("disks").a.size(); ++i) {
-                    const auto& d = v.at("disks").a[i];
-                    std::string part;
-                    if (d.is_object()) {
-                        part = d.at("mount").s + ":" + std::to_string((long long)d.at("total_gb").num) + "/" + std::to_string((long long)d.at("free_gb").num);
-                    }
-                    disks += part;
-                    if (i+1 < v.at("disks").a.size()) disks += " | ";
-                }
+            metrics::Timer parse_timer(metrics::Stage::JsonParse);
+            p->doc = minijson::Document::parse(p->body);
+            parse_timer.stop();
+            const auto& v = p->doc.root();
+            std::string why;
+            metrics::Timer validate_timer(metrics::Stage::Validate);
+            bool valid = inventory::validate_asset_schema(v, why);
+            validate_timer.stop();
+            if (!valid) {
+                return reply(400, "application/json; charset=utf-8",
+                    std::string("{\"ok\":false,\"error\":\"schema_invalid\",\"detail\":\"") + why + "\"}");
             }
-            auto esc = [](std::string s){
-                // naive CSV escape
-                bool need = s.find(',')!=std::string::npos || s.find('"')!=std::string::npos || s.find('\n')!=std::string::npos;
-                if (!need) return s;
-                std::string out="\"";
-                for (char c: s) { if (c=='"') out += "\"\""; else out += c; }
-                out += "\"";
-                return out;
+            // The append is not under g_store_mu so that concurrent POSTs can
+            // share one write (and fsync); the index orders them by position.
+            auto op = std::make_shared<StoreOp>();
+            op->lines.push_back(minijson::stringify(v, false));
+            op->finish = [p, reply](const filestore::AppendResult& res) {
+                if (!res.error.empty()) {
+                    logutil::error("server", res.error);
+                    return reply(500, "application/json; charset=utf-8",
+                        std::string("{\"ok\":false,\"error\":\"store_failed\"}"));
+                }
+                const auto& v = p->doc.root();
+                {
+                    std::unique_lock<std::shared_mutex> lk(g_store_mu);
+                    g_index.upsert(v, res.positions[0]);
+                    g_generation++;
+                }
+                LOGUTIL(Debug, "server", "asset stored", {{"asset_id", v.at("asset_id").string()}, {"position", res.positions[0]}});
+                return reply(201, "application/json; charset=utf-8", std::string("{\"ok\":true}"));
             };
-            o << esc(v.at("asset_id").s) << ","
-              << esc(v.at("hostname").s) << ","
-              << esc(v.at("os").s) << ","
-              << esc(v.at("cpu_model").s) << ","
-              << (long long)v.at("cpu_cores").num << ","
-              << (long long)v.at("ram_total_mb").num << ","
-              << esc(v.at("timestamp_utc").s) << ","
-              << esc(disks) << "\n";
-        } catch (...) {}
+            return deferred(std::move(op));
+        } catch (const std::exception& e) {
+            return reply(400, "application/json; charset=utf-8",
+                std::string("{\"ok\":false,\"error\":\"invalid_json\",\"detail\":\"") + e.what() + "\"}");
+        }
     }
-    return o.str();
+    return reply(404, "text/plain", "not found");
 }
 
-namespace httpserver {
+// Replies start with "HTTP/1.1 NNN".
+static int reply_status(const Reply& r) {
+    if (r.head.size() < 12) return 0;
+    return (r.head[9] - '0') * 100 + (r.head[10] - '0') * 10 + (r.head[11] - '0');
+}
 
-int run(int port) {
-    std::string err;
-    if (!sock_init(err)) {
-        logutil::error("server", err);
-        return 1;
+// A reply with `store` set is counted once finish_store has built it.
+static Reply handle_request(const httpparser::Request& req, bool keep_alive) {
+    metrics::Route route = metrics::Route::Other;
+    Reply r = route_request(req, keep_alive, route);
+    if (r.store) {
+        r.store->route = route;
+        r.store->started_ns = metrics::enabled() ? metrics::now_ns() : 0;
+    } else {
+        metrics::count_request(route, reply_status(r));
     }
+    return r;
+}
 
+static Reply finish_store(StoreOp& op, const filestore::AppendResult& res) {
+    if (op.started_ns) metrics::observe(metrics::Stage::Append, metrics::now_ns() - op.started_ns);
+    Reply r = op.finish(res);
+    metrics::count_request(op.route, reply_status(r));
+    return r;
+}
+
+// Single-thread mode: stores the records inline.
+static Reply store_blocking(Reply r) {
+    if (!r.store) return r;
+    filestore::AppendResult res;
+    if (!r.store->lines.empty()) g_writer->append_many(r.store->lines, res.error, &res.positions);
+    return finish_store(*r.store, res);
+}
+
+// Framing errors never reach a route.
+static std::string error_response(const httpparser::Parser& parser) {
+    metrics::count_request(metrics::Route::Other, parser.error_status());
+    return http_response(parser.error_status(), "text/plain", parser.error());
+}
+
+static int open_listener(int port, int backlog, bool reuse_port) {
     int srv = (int)socket(AF_INET, SOCK_STREAM, 0);
 #ifdef _WIN32
-    if (srv == (int)INVALID_SOCKET) { logutil::error("server", "socket() gagal"); sock_cleanup(); return 1; }
+    if (srv == (int)INVALID_SOCKET) { logutil::error("server", "socket() gagal"); return -1; }
 #else
-    if (srv < 0) { logutil::error("server", "socket() gagal"); sock_cleanup(); return 1; }
+    if (srv < 0) { logutil::error("server", "socket() gagal"); return -1; }
 #endif
 
     int opt = 1;
 #ifdef _WIN32
     setsockopt((SOCKET)srv, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt));
+    (void)reuse_port;
 #else
     setsockopt(srv, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+  #ifdef SO_REUSEPORT
+    if (reuse_port) setsockopt(srv, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+  #endif
 #endif
 
     sockaddr_in addr{};
@@ -285,8 +957,7 @@ int run(int port) {
         (sockaddr*)&addr, sizeof(addr)) != 0) {
         logutil::error("server", "bind() gagal (port mungkin dipakai)");
         sock_close(srv);
-        sock_cleanup();
-        return 1;
+        return -1;
     }
 
     if (listen(
@@ -295,15 +966,19 @@ int run(int port) {
 #else
         srv,
 #endif
-        16) != 0) {
+        backlog) != 0) {
         logutil::error("server", "listen() gagal");
         sock_close(srv);
-        sock_cleanup();
-        return 1;
+        return -1;
     }
+    return srv;
+}
 
-    logutil::info("server", "running on http://localhost:" + std::to_string(port));
-
+// Original model: accept one connection, read one request, answer, close.
+// Kept for platforms without epoll and as a benchmark baseline.
+static void run_single_thread(int srv) {
+    std::string buf;
+    httpparser::Parser parser;
     while (true) {
         sockaddr_in caddr{};
 #ifdef _WIN32
@@ -317,55 +992,530 @@ int run(int port) {
         if (fd < 0) continue;
 #endif
 
-        std::string req = read_request(fd);
-        std::string method, path;
-        if (!parse_start_line(req, method, path)) {
+        buf.clear();
+        parser.reset();
+        metrics::Timer read_timer(metrics::Stage::ReadRequest);
+        auto st = read_request(fd, buf, parser);
+        read_timer.stop();
+        if (st == httpparser::Status::Complete) {
+            Reply r = store_blocking(handle_request(parser.request(), false));
+            bool ok = send_all(fd, r.head) && (!r.body || send_all(fd, *r.body));
+            // blocking sends pace the stream
+            std::string piece;
+            for (bool more = r.stream != nullptr; ok && more; ) {
+                piece.clear();
+                more = r.stream->next(piece);
+                ok = send_all(fd, piece);
+            }
+        } else if (st == httpparser::Status::Error) {
+            send_all(fd, error_response(parser));
+        } else {
+            metrics::count_request(metrics::Route::Other, 400);
             send_all(fd, http_response(400, "text/plain", "bad request"));
-            sock_close(fd);
-            continue;
-        }
-
-        // Ensure body length if content-length exists (our read_request may have already read all; ok for small payloads)
-        std::string body = get_body(req);
-
-        if (method == "GET" && path == "/") {
-            auto html = html_dashboard();
-            send_all(fd, http_response(200, "text/html; charset=utf-8", html));
-        } else if (method == "GET" && path == "/api/assets") {
-            auto js = json_array_from_store();
-            send_all(fd, http_response(200, "application/json; charset=utf-8", js));
-        } else if (method == "GET" && path == "/export.csv") {
-            auto csv = csv_from_store();
-            send_all(fd, http_response(200, "text/csv; charset=utf-8", csv));
-        } else if (method == "POST" && path == "/api/assets") {
-            try {
-                auto v = minijson::parse(body);
-                std::string why;
-                if (!inventory::validate_asset_schema(v, why)) {
-                    send_all(fd, http_response(400, "application/json; charset=utf-8",
-                        std::string("{\"ok\":false,\"error\":\"schema_invalid\",\"detail\":\"") + why + "\"}"));
-                } else {
-                    std::string line = minijson::stringify(v, false);
-                    std::string ferr;
-                    if (!filestore::append_line("data/assets.jsonl", line, ferr)) {
-                        send_all(fd, http_response(500, "application/json; charset=utf-8",
-                            std::string("{\"ok\":false,\"error\":\"store_failed\"}")));
-                    } else {
-                        send_all(fd, http_response(201, "application/json; charset=utf-8",
-                            std::string("{\"ok\":true}")));
-                    }
+        }
+        sock_close(fd);
+    }
+}
+
+#ifdef __linux__
+
+struct OutChunk {
+    std::string owned;
+    std::shared_ptr<const std::string> shared;
+
+    const char* data() const { return shared ? shared->data() : owned.data(); }
+    size_t size() const { return shared ? shared->size() : owned.size(); }
+};
+
+struct Conn {
+    int fd = -1;
+    uint64_t id = 0; // tells a completion apart from a later conn on the same fd
+    // Reusable input buffer; [in_off, in_len) holds bytes not yet consumed
+    // by a completed request, so pipelined requests are parsed in place.
+    std::string in;
+    size_t in_off = 0;
+    size_t in_len = 0;
+    httpparser::Parser parser;
+    // Queued response bytes; out_off is the sent prefix of out.front().
+    std::deque<OutChunk> out;
+    size_t out_off = 0;
+    size_t out_pending = 0;
+    // Body of the response being streamed; requests pipelined behind it wait
+    // in `in` until it completes.
+    std::unique_ptr<BodyStream> stream;
+    // A POST's records are being stored; later requests wait like for stream.
+    bool storing = false;
+    // now_ns() when the first byte of the request being read arrived (or,
+    // for one pipelined behind another, when parsing it began); 0 between
+    // requests or with metrics off.
+    uint64_t read_started_ns = 0;
+    int served = 0;
+    bool close_after = false;
+    bool peer_closed = false;
+    bool read_paused = false;
+    std::chrono::steady_clock::time_point last_active;
+};
+
+// Appends completed by the store's writer thread for one reactor. The
+// writer pushes, the reactor drains; the eventfd wakes its epoll_wait when
+// the queue becomes non-empty.
+struct StoreCompletions {
+    struct Item {
+        int fd;
+        uint64_t conn_id;
+        std::shared_ptr<StoreOp> op;
+        filestore::AppendResult result;
+    };
+
+    int efd = -1;
+    std::mutex mu;
+    std::vector<Item> items;
+
+    ~StoreCompletions() { if (efd >= 0) close(efd); }
+
+    void push(Item&& item) {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            wake = items.empty();
+            items.push_back(std::move(item));
+        }
+        if (wake) {
+            uint64_t one = 1;
+            ssize_t n = write(efd, &one, sizeof(one));
+            (void)n;
+        }
+    }
+};
+
+// Stop reading from a connection while this many response bytes are queued.
+static constexpr size_t kMaxPendingOut = 4*1024*1024;
+// Pull the next piece of a streamed body once queued output drops below this.
+static constexpr size_t kStreamLowWater = 64*1024;
+// Stream bytes sent to one connection per event-loop round; a fast client
+// then yields to the others instead of taking the whole body in one go.
+static constexpr size_t kStreamRoundBytes = 1024*1024;
+
+// One edge-triggered epoll loop per thread, each with its own SO_REUSEPORT
+// listener so the kernel spreads incoming connections across workers.
+// Connections are persistent (HTTP/1.1 keep-alive) and pipelined requests
+// are answered in order. POSTs never block the loop on the disk: their
+// records go to the AppendWriter and the reply is queued when it reports
+// back through done_.
+class Reactor {
+public:
+    Reactor(int listen_fd, const httpserver::Options& opt): lfd_(listen_fd), opt_(opt) {}
+
+    void loop() {
+        ep_ = epoll_create1(EPOLL_CLOEXEC);
+        if (ep_ < 0) { logutil::error("server", "epoll_create1() gagal"); return; }
+        set_nonblocking(lfd_);
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.fd = lfd_;
+        epoll_ctl(ep_, EPOLL_CTL_ADD, lfd_, &ev);
+        done_->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (done_->efd < 0) { logutil::error("server", "eventfd() gagal"); return; }
+        ev.data.fd = done_->efd;
+        epoll_ctl(ep_, EPOLL_CTL_ADD, done_->efd, &ev);
+
+        const int idle_ms = opt_.idle_timeout_ms > 0 ? opt_.idle_timeout_ms : 0;
+        const int wait_ms = idle_ms > 0 ? std::min(idle_ms, 1000) : -1;
+        auto last_sweep = std::chrono::steady_clock::now();
+
+        epoll_event events[256];
+        while (true) {
+            int n = epoll_wait(ep_, events, 256, ready_.empty() ? wait_ms : 0);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                logutil::error("server", "epoll_wait() gagal");
+                return;
+            }
+            auto now = std::chrono::steady_clock::now();
+            for (int i=0;i<n;i++) {
+                int fd = events[i].data.fd;
+                if (fd == lfd_) { accept_all(now); continue; }
+                if (fd == done_->efd) { complete_stores(now); continue; }
+                auto it = conns_.find(fd);
+                if (it == conns_.end()) continue;
+                Conn& c = *it->second;
+                if (events[i].events & EPOLLERR) { close_conn(fd); continue; }
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) {
+                    if (!on_readable(c, now)) { close_conn(fd); continue; }
                 }
-            } catch (const std::exception& e) {
-                send_all(fd, http_response(400, "application/json; charset=utf-8",
-                    std::string("{\"ok\":false,\"error\":\"invalid_json\",\"detail\":\"") + e.what() + "\"}"));
+                if (!flush(c, now)) { close_conn(fd); continue; }
+                if (!settle(c, now)) close_conn(fd);
+            }
+            // Streams that stopped at their round budget with the socket
+            // still writable get no new edge; continue them here.
+            std::vector<int> ready;
+            ready.swap(ready_);
+            for (int fd : ready) {
+                auto it = conns_.find(fd);
+                if (it == conns_.end()) continue;
+                Conn& c = *it->second;
+                if (!flush(c, now) || !settle(c, now)) close_conn(fd);
             }
+            if (idle_ms > 0 && now - last_sweep >= std::chrono::milliseconds(wait_ms)) {
+                sweep_idle(now, std::chrono::milliseconds(idle_ms));
+                last_sweep = now;
+            }
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // After a flush: resumes reading once output (and any stream) has
+    // drained, answering requests that were held back. Returns false when the
+    // connection should be closed.
+    bool settle(Conn& c, Clock::time_point now) {
+        if (c.read_paused && !c.stream && !c.storing && c.out_pending < kMaxPendingOut) {
+            c.read_paused = false;
+            process(c);
+            if (!on_readable(c, now) || !flush(c, now)) return false;
+        }
+        bool drained = c.out.empty() && !c.stream && !c.storing;
+        return !(drained && (c.close_after || c.peer_closed));
+    }
+
+    static void set_nonblocking(int fd) {
+        int fl = fcntl(fd, F_GETFL, 0);
+        if (fl >= 0) fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+    }
+
+    void accept_all(Clock::time_point now) {
+        while (true) {
+            const uint64_t t0 = metrics::enabled() ? metrics::now_ns() : 0;
+            int fd = accept4(lfd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return; // EAGAIN, or transient error: wait for the next edge
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            ev.data.fd = fd;
+            if (epoll_ctl(ep_, EPOLL_CTL_ADD, fd, &ev) != 0) { close(fd); continue; }
+            auto c = std::make_unique<Conn>();
+            c->fd = fd;
+            c->id = ++next_id_;
+            c->last_active = now;
+            conns_[fd] = std::move(c);
+            if (t0) metrics::observe(metrics::Stage::Accept, metrics::now_ns() - t0);
+        }
+    }
+
+    // Drains the socket straight into the connection buffer, answering every
+    // complete request as it arrives; returns false on a hard error.
+    bool on_readable(Conn& c, Clock::time_point now) {
+        while (!c.peer_closed) {
+            if (c.close_after) {
+                // Response is final; discard anything the client still sends.
+                char sink[4096];
+                ssize_t n = recv(c.fd, sink, sizeof(sink), 0);
+                if (n > 0) continue;
+                if (n == 0) { c.peer_closed = true; break; }
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return false;
+            }
+            if (c.out_pending >= kMaxPendingOut || c.stream || c.storing) {
+                // Client is not reading its responses, or a streamed body or
+                // a store is in flight; resume once done.
+                c.read_paused = true;
+                break;
+            }
+            if (c.in.size() - c.in_len < 4096) {
+                if (c.in_off > 0) {
+                    std::memmove(&c.in[0], c.in.data() + c.in_off, c.in_len - c.in_off);
+                    c.in_len -= c.in_off;
+                    c.in_off = 0;
+                }
+                if (c.in.size() - c.in_len < 4096) c.in.resize(c.in_len + 16384);
+            }
+            ssize_t n = recv(c.fd, &c.in[c.in_len], c.in.size() - c.in_len, 0);
+            if (n > 0) {
+                c.in_len += (size_t)n;
+                c.last_active = now;
+                if (!c.read_started_ns && metrics::enabled()) c.read_started_ns = metrics::now_ns();
+                process(c);
+                continue;
+            }
+            if (n == 0) { c.peer_closed = true; break; }
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        return true;
+    }
+
+    void process(Conn& c) {
+        while (!c.close_after && !c.stream && !c.storing && c.in_off < c.in_len) {
+            if (!c.read_started_ns && metrics::enabled()) c.read_started_ns = metrics::now_ns();
+            auto st = c.parser.parse(std::string_view(c.in.data() + c.in_off, c.in_len - c.in_off));
+            if (st == httpparser::Status::Incomplete) return;
+            if (c.read_started_ns) {
+                metrics::observe(metrics::Stage::ReadRequest, metrics::now_ns() - c.read_started_ns);
+                c.read_started_ns = 0;
+            }
+            if (st == httpparser::Status::Error) {
+                queue(c, Reply(error_response(c.parser)));
+                c.close_after = true;
+                return;
+            }
+            const auto& req = c.parser.request();
+            c.served++;
+            bool keep = opt_.keep_alive && req.keep_alive() &&
+                        (opt_.max_requests_per_conn <= 0 || c.served < opt_.max_requests_per_conn);
+            Reply r = handle_request(req, keep);
+            if (!keep || r.close_after) c.close_after = true;
+            if (r.store) start_store(c, std::move(r.store));
+            else queue(c, std::move(r));
+            c.in_off += c.parser.consumed();
+            c.parser.reset();
+            if (c.in_off == c.in_len) c.in_off = c.in_len = 0;
+        }
+    }
+
+    // Hands a POST's records to the writer; complete_stores queues the reply.
+    void start_store(Conn& c, std::shared_ptr<StoreOp> op) {
+        if (op->lines.empty()) {
+            queue(c, finish_store(*op, filestore::AppendResult{}));
+            return;
+        }
+        c.storing = true;
+        auto done = done_;
+        const int fd = c.fd;
+        const uint64_t id = c.id;
+        g_writer->append_async(op->lines, [done, fd, id, op](filestore::AppendResult&& res) {
+            done->push(StoreCompletions::Item{fd, id, op, std::move(res)});
+        });
+    }
+
+    // Indexes stored records and answers their requests, then carries on
+    // with whatever the connections pipelined behind them. The index is
+    // updated even when the connection has gone away meanwhile.
+    void complete_stores(Clock::time_point now) {
+        uint64_t n;
+        while (read(done_->efd, &n, sizeof(n)) > 0) {}
+        std::vector<StoreCompletions::Item> items;
+        {
+            std::lock_guard<std::mutex> lk(done_->mu);
+            items.swap(done_->items);
+        }
+        for (auto& item : items) {
+            Reply r = finish_store(*item.op, item.result);
+            auto it = conns_.find(item.fd);
+            if (it == conns_.end() || it->second->id != item.conn_id) continue;
+            Conn& c = *it->second;
+            c.storing = false;
+            c.last_active = now;
+            if (r.close_after) c.close_after = true;
+            queue(c, std::move(r));
+            process(c);
+            if (!flush(c, now) || !settle(c, now)) close_conn(item.fd);
+        }
+    }
+
+    static void queue(Conn& c, Reply&& r) {
+        c.out_pending += r.head.size();
+        // Small heads of consecutive pipelined responses share one chunk.
+        if (!c.out.empty() && !c.out.back().shared) {
+            c.out.back().owned += r.head;
         } else {
-            send_all(fd, http_response(404, "text/plain", "not found"));
+            c.out.push_back(OutChunk{std::move(r.head), nullptr});
         }
+        if (r.body && !r.body->empty()) {
+            c.out_pending += r.body->size();
+            c.out.push_back(OutChunk{std::string(), std::move(r.body)});
+        }
+        c.stream = std::move(r.stream);
+    }
 
-        sock_close(fd);
+    // Queues the next piece of the connection's streamed body.
+    static void pull(Conn& c) {
+        std::string piece;
+        if (!c.stream->next(piece)) c.stream.reset();
+        if (piece.empty()) return;
+        c.out_pending += piece.size();
+        c.out.push_back(OutChunk{std::move(piece), nullptr});
+    }
+
+    // Gathers queued chunks into one sendmsg per round, refilling from the
+    // body stream as the queue drains.
+    bool flush(Conn& c, Clock::time_point now) {
+        size_t streamed = 0;
+        while (true) {
+            if (c.stream && c.out_pending < kStreamLowWater) {
+                if (streamed >= kStreamRoundBytes) { ready_.push_back(c.fd); return true; }
+                size_t before = c.out_pending;
+                pull(c);
+                streamed += c.out_pending - before;
+            }
+            if (c.out.empty()) {
+                if (c.stream) continue;
+                return true;
+            }
+            iovec iov[16];
+            int cnt = 0;
+            size_t off = c.out_off;
+            for (auto it = c.out.begin(); it != c.out.end() && cnt < 16; ++it, off = 0) {
+                iov[cnt].iov_base = const_cast<char*>(it->data() + off);
+                iov[cnt].iov_len = it->size() - off;
+                cnt++;
+            }
+            msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = (size_t)cnt;
+            metrics::Timer send_timer(metrics::Stage::Send);
+            ssize_t n = sendmsg(c.fd, &msg, MSG_NOSIGNAL);
+            send_timer.stop();
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+            if (n <= 0) return false;
+            c.last_active = now;
+            c.out_pending -= (size_t)n;
+            size_t left = (size_t)n;
+            while (left > 0) {
+                size_t avail = c.out.front().size() - c.out_off;
+                if (left < avail) { c.out_off += left; break; }
+                left -= avail;
+                c.out.pop_front();
+                c.out_off = 0;
+            }
+        }
+    }
+
+    void sweep_idle(Clock::time_point now, std::chrono::milliseconds idle) {
+        std::vector<int> expired;
+        for (const auto& kv : conns_) {
+            if (!kv.second->storing && now - kv.second->last_active >= idle) expired.push_back(kv.first);
+        }
+        for (int fd : expired) close_conn(fd);
     }
 
+    void close_conn(int fd) {
+        epoll_ctl(ep_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        conns_.erase(fd);
+    }
+
+    int lfd_;
+    httpserver::Options opt_;
+    int ep_ = -1;
+    std::unordered_map<int, std::unique_ptr<Conn>> conns_;
+    std::vector<int> ready_; // connections to flush again next round
+    std::shared_ptr<StoreCompletions> done_ = std::make_shared<StoreCompletions>();
+    uint64_t next_id_ = 0;
+};
+
+#endif // __linux__
+
+// Folds sealed store segments into a latest-per-asset snapshot (or one
+// record per asset per UTC day with history), so startup and full scans stay
+// proportional to the fleet rather than to uptime.
+static void compactor_loop(int interval_s, bool daily_history) {
+    auto key = [daily_history](std::string_view line, std::string& key) {
+        try {
+            auto doc = minijson::Document::parse(line);
+            std::string why;
+            if (!inventory::validate_asset_schema(doc.root(), why)) return false;
+            key = doc.root().at("asset_id").string();
+            if (daily_history) {
+                key += '\n';
+                key += doc.root().at("timestamp_utc").string().substr(0, 10);
+            }
+            return true;
+        } catch (...) {
+            return false;
+        }
+    };
+    for (;;) {
+        std::this_thread::sleep_for(std::chrono::seconds(interval_s));
+        filestore::CompactStats st;
+        std::string err;
+        if (!filestore::compact(kStorePath, key, st, err)) {
+            logutil::error("compactor", err);
+        } else if (st.segments) {
+            LOGUTIL(Info, "compactor", "snapshot written",
+                    {{"seq", st.seq}, {"segments", st.segments}, {"records_in", st.lines_in},
+                     {"records_out", st.lines_out}, {"bytes_in", st.bytes_in}, {"bytes_out", st.bytes_out}});
+        }
+    }
+}
+
+namespace httpserver {
+
+int run(int port) {
+    Options opt;
+    opt.port = port;
+    return run(opt);
+}
+
+int run(const Options& opt) {
+    std::string err;
+    if (!sock_init(err)) {
+        logutil::error("server", err);
+        return 1;
+    }
+
+    // One writer and compactor per process (run() may be called again, e.g.
+    // by bench_load). Opening the writer also clears files left behind by an
+    // interrupted compaction.
+    g_stream_min_assets = opt.stream_min_assets;
+    g_gzip = opt.gzip;
+    metrics::set_enabled(opt.metrics);
+
+    bool first = !g_writer;
+    if (first) g_writer = std::make_unique<filestore::AppendWriter>(kStorePath, opt.store);
+    if (!g_writer->open(err)) {
+        logutil::error("server", err);
+        sock_cleanup();
+        return 1;
+    }
+    if (first && opt.compact_interval_s > 0) {
+        std::thread(compactor_loop, opt.compact_interval_s, opt.compact_history).detach();
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lk(g_store_mu);
+        size_t lines = g_index.load(kStorePath);
+        LOGUTIL(Info, "server", "index loaded", {{"assets", g_index.size()}, {"records", lines}});
+    }
+
+#ifdef __linux__
+    if (!opt.single_thread) {
+        int threads = opt.threads > 0 ? opt.threads : (int)std::thread::hardware_concurrency();
+        if (threads <= 0) threads = 1;
+
+        std::vector<int> listeners;
+        for (int i=0;i<threads;i++) {
+            int fd = open_listener(opt.port, opt.backlog, true);
+            if (fd < 0) {
+                for (int l : listeners) sock_close(l);
+                sock_cleanup();
+                return 1;
+            }
+            listeners.push_back(fd);
+        }
+
+        LOGUTIL(Info, "server", "running", {{"port", opt.port}, {"mode", "epoll"}, {"threads", threads}});
+
+        std::vector<std::thread> workers;
+        for (int fd : listeners) {
+            workers.emplace_back([fd, &opt]{ Reactor r(fd, opt); r.loop(); });
+        }
+        for (auto& t : workers) t.join();
+
+        for (int fd : listeners) sock_close(fd);
+        sock_cleanup();
+        return 1; // workers only return on fatal epoll errors
+    }
+#endif
+
+    int srv = open_listener(opt.port, opt.backlog, false);
+    if (srv < 0) { sock_cleanup(); return 1; }
+
+    LOGUTIL(Info, "server", "running", {{"port", opt.port}, {"mode", "single_thread"}});
+    run_single_thread(srv);
+
     // never reached
     sock_close(srv);
     sock_cleanup();
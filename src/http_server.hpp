@@ -1,6 +1,45 @@
 #pragma once
 #include <string>
+#include "file_store.hpp"
 
 namespace httpserver {
-    int run(int port);
-}
+
+struct Options {
+    int port = 8080;
+    // Number of epoll worker threads; 0 = std::thread::hardware_concurrency().
+    int threads = 0;
+    // Use the original one-connection-at-a-time accept loop (always used where
+    // epoll is unavailable).
+    bool single_thread = false;
+    int backlog = 1024;
+    // Persistent connections (epoll mode): idle connections are closed after
+    // idle_timeout_ms, and each connection serves at most
+    // max_requests_per_conn requests (0 = unlimited).
+    bool keep_alive = true;
+    int idle_timeout_ms = 5000;
+    int max_requests_per_conn = 1000;
+    // Appends to data/assets.jsonl: fsync policy, and whether the 201 waits
+    // until the record is durable (strict) or only written.
+    // Also the segment limits (store.segment_bytes / segment_seconds).
+    filestore::WriterOptions store;
+    // Every compact_interval_s seconds (0 = never) sealed segments are merged
+    // into a snapshot holding the latest record per asset, or with
+    // compact_history one record per asset per UTC day.
+    int compact_interval_s = 300;
+    bool compact_history = false;
+    // GET /api/assets (no parameters) and /export.csv are rendered once per
+    // store generation and cached while the fleet is smaller than
+    // stream_min_assets, and streamed (chunked, row by row) from then on,
+    // gzip-compressed when the client accepts it and gzip is set (builds
+    // with zlib only).
+    size_t stream_min_assets = 10000;
+    bool gzip = true;
+    // Per-route request counts and stage latency histograms, served on
+    // GET /metrics (see metrics.hpp). Off: no clock reads on the hot path.
+    bool metrics = true;
+};
+
+int run(int port);
+int run(const Options& opt);
+
+} // namespace httpserver
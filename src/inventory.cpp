@@ -2,6 +2,9 @@
 #include "platform.hpp"
 #include <sstream>
 #include <functional>
+#include <cstdio>
+#include <cstdint>
+#include <ctime>
 
 namespace inventory {
 
@@ -14,12 +17,86 @@ std::string make_asset_id(const std::string& hostname) {
     return o.str();
 }
 
+std::string payload_version(const minijson::Value& payload) {
+    minijson::Value v = payload;
+    v.o.erase("timestamp_utc");
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : minijson::stringify(v)) { h ^= c; h *= 1099511628211ULL; }
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+    return buf;
+}
+
+void payload_delta(const minijson::Value& base, const minijson::Value& current,
+                   minijson::Value& set, std::vector<std::string>& unset) {
+    set = minijson::Value::object({});
+    unset.clear();
+    for (const auto& kv : current.o) {
+        if (kv.first == "asset_id" || kv.first == "timestamp_utc") continue;
+        auto it = base.o.find(kv.first);
+        if (it == base.o.end() || minijson::stringify(it->second) != minijson::stringify(kv.second)) {
+            set.o[kv.first] = kv.second;
+        }
+    }
+    for (const auto& kv : base.o) {
+        if (kv.first == "asset_id" || kv.first == "timestamp_utc") continue;
+        if (!current.has(kv.first)) unset.push_back(kv.first);
+    }
+}
+
+bool valid_timestamp_utc(std::string_view ts) {
+    static const char kShape[] = "0000-00-00T00:00:00Z";
+    if (ts.size() != sizeof(kShape) - 1) return false;
+    for (size_t i=0;i<ts.size();i++) {
+        if (kShape[i] == '0' ? (ts[i] < '0' || ts[i] > '9') : ts[i] != kShape[i]) return false;
+    }
+    auto num = [ts](size_t at) { return (ts[at] - '0') * 10 + (ts[at + 1] - '0'); };
+    return num(5) >= 1 && num(5) <= 12 && num(8) >= 1 && num(8) <= 31 &&
+           num(11) <= 23 && num(14) <= 59 && num(17) <= 60;
+}
+
+bool apply_delta(minijson::Value& record, const minijson::Node& delta, std::string& why) {
+    const minijson::Node* ts = delta.is_object() ? delta.find("timestamp_utc") : nullptr;
+    if (!ts || !ts->is_string()) { why = "field string wajib: timestamp_utc"; return false; }
+    if (!valid_timestamp_utc(ts->string())) { why = "timestamp_utc harus berformat YYYY-MM-DDTHH:MM:SSZ"; return false; }
+    auto fixed = [](std::string_view k) { return k == "asset_id" || k == "timestamp_utc"; };
+    if (const auto* set = delta.find("set")) {
+        if (!set->is_object()) { why = "set harus object"; return false; }
+        for (auto m = set->members_begin(); m != set->members_end(); ++m) {
+            if (fixed(m->key)) { why = "field tidak boleh diubah lewat delta: " + std::string(m->key); return false; }
+            record.o[std::string(m->key)] = m->value.to_value();
+        }
+    }
+    if (const auto* unset = delta.find("unset")) {
+        if (!unset->is_array()) { why = "unset harus array"; return false; }
+        for (const auto& k : *unset) {
+            if (!k.is_string()) { why = "unset harus berisi string"; return false; }
+            if (fixed(k.string())) { why = "field tidak boleh diubah lewat delta: " + std::string(k.string()); return false; }
+            record.o.erase(std::string(k.string()));
+        }
+    }
+    record.o["timestamp_utc"] = minijson::Value::string(std::string(ts->string()));
+    return true;
+}
+
 minijson::Value build_asset_payload(const std::string& agent_version) {
+    return AssetCollector(agent_version).collect();
+}
+
+minijson::Value AssetCollector::collect() {
     using minijson::Value;
 
+    const long long now = (long long)std::time(nullptr);
+    const long long stamp = platforminfo::static_facts_stamp();
+    if (fact_reads_ == 0 || stamp != stamp_ || now - read_at_ >= kFactsMaxAge || now < read_at_) {
+        os_ = platforminfo::os_name();
+        cpu_ = platforminfo::cpu_brand();
+        stamp_ = stamp;
+        read_at_ = now;
+        fact_reads_++;
+    }
+
     std::string host = platforminfo::hostname();
-    std::string os = platforminfo::os_name();
-    std::string cpu = platforminfo::cpu_brand();
     int cores = platforminfo::cpu_cores();
     long long ram = platforminfo::ram_total_mb();
     auto disks = platforminfo::disks();
@@ -36,13 +113,13 @@ minijson::Value build_asset_payload(const std::string& agent_version) {
     Value root = Value::object({
         {"asset_id", Value::string(make_asset_id(host))},
         {"hostname", Value::string(host)},
-        {"os", Value::string(os)},
-        {"cpu_model", Value::string(cpu)},
+        {"os", Value::string(os_)},
+        {"cpu_model", Value::string(cpu_)},
         {"cpu_cores", Value::number((double)cores)},
         {"ram_total_mb", Value::number((double)ram)},
         {"disks", Value::array(std::move(disk_arr))},
         {"timestamp_utc", Value::string(platforminfo::now_iso_utc())},
-        {"agent_version", Value::string(agent_version)}
+        {"agent_version", Value::string(agent_version_)}
     });
 
     return root;
@@ -51,10 +128,16 @@ minijson::Value build_asset_payload(const std::string& agent_version) {
 static bool is_num_intish(const minijson::Value& v) {
     return v.is_number();
 }
+static bool is_num_intish(const minijson::Node& v) {
+    return v.is_number();
+}
 
-bool validate_asset_schema(const minijson::Value& root, std::string& why) {
-    using Type = minijson::Value::Type;
+static const std::vector<minijson::Value>& items(const minijson::Value& v) { return v.a; }
+static const minijson::Node& items(const minijson::Node& v) { return v; }
 
+// Shared by the Value and the compact Node representation.
+template <class V>
+static bool validate_impl(const V& root, std::string& why) {
     if (!root.is_object()) { why = "root bukan object"; return false; }
 
     const char* req_str[] = {"asset_id","hostname","os","cpu_model","timestamp_utc","agent_version"};
@@ -66,7 +149,7 @@ bool validate_asset_schema(const minijson::Value& root, std::string& why) {
     if (!root.has("ram_total_mb") || !root.at("ram_total_mb").is_number()) { why = "field number wajib: ram_total_mb"; return false; }
 
     if (!root.has("disks") || !root.at("disks").is_array()) { why = "field array wajib: disks"; return false; }
-    for (const auto& d : root.at("disks").a) {
+    for (const auto& d : items(root.at("disks"))) {
         if (!d.is_object()) { why = "disk item bukan object"; return false; }
         if (!d.has("mount") || !d.at("mount").is_string()) { why = "disk.mount wajib string"; return false; }
         if (!d.has("total_gb") || !d.at("total_gb").is_number()) { why = "disk.total_gb wajib number"; return false; }
@@ -77,4 +160,112 @@ bool validate_asset_schema(const minijson::Value& root, std::string& why) {
     return true;
 }
 
+bool validate_asset_schema(const minijson::Value& root, std::string& why) {
+    return validate_impl(root, why);
+}
+
+bool validate_asset_schema(const minijson::Node& root, std::string& why) {
+    return validate_impl(root, why);
+}
+
+// Top-level fields in the order validate_impl checks them.
+static const char* const kFieldNames[9] = {
+    "asset_id","hostname","os","cpu_model","timestamp_utc","agent_version","cpu_cores","ram_total_mb","disks"
+};
+static const char* const kFieldErrors[9] = {
+    "field string wajib: asset_id", "field string wajib: hostname", "field string wajib: os",
+    "field string wajib: cpu_model", "field string wajib: timestamp_utc", "field string wajib: agent_version",
+    "field number wajib: cpu_cores", "field number wajib: ram_total_mb", "field array wajib: disks"
+};
+static const char* const kDiskFieldNames[3] = {"mount","total_gb","free_gb"};
+static const char* const kDiskFieldErrors[3] = {
+    "disk.mount wajib string", "disk.total_gb wajib number", "disk.free_gb wajib number"
+};
+static const int kDisksField = 8;
+
+template <size_t N>
+static int field_index(const char* const (&names)[N], std::string_view k) {
+    for (size_t i=0;i<N;i++) if (k == names[i]) return (int)i;
+    return -1;
+}
+
+bool AssetSchemaValidator::on_value(Kind k) {
+    if (depth_ == 0) {
+        root_object_ = k == Kind::Object;
+        return root_object_; // nothing else matters once the root is wrong
+    }
+    if (depth_ == 1) {
+        if (field_ >= 0 && fields_[field_] == Missing) {
+            Kind want = field_ < 6 ? Kind::String : field_ < 8 ? Kind::Number : Kind::Array;
+            fields_[field_] = k == want ? Ok : WrongType;
+            if (field_ == kDisksField && k == Kind::Array) in_disks_ = true;
+        }
+        field_ = -1;
+    } else if (depth_ == 2 && in_disks_) {
+        if (k == Kind::Object) {
+            in_item_ = true;
+            item_field_ = -1;
+            item_[0] = item_[1] = item_[2] = Missing;
+        } else if (!disk_error_) {
+            disk_error_ = "disk item bukan object";
+        }
+    } else if (depth_ == 3 && in_item_) {
+        if (item_field_ >= 0 && item_[item_field_] == Missing) {
+            Kind want = item_field_ == 0 ? Kind::String : Kind::Number;
+            item_[item_field_] = k == want ? Ok : WrongType;
+        }
+        item_field_ = -1;
+    }
+    return true;
+}
+
+bool AssetSchemaValidator::key(std::string_view k) {
+    if (depth_ == 1) field_ = field_index(kFieldNames, k);
+    else if (depth_ == 3 && in_item_) item_field_ = field_index(kDiskFieldNames, k);
+    return true;
+}
+
+bool AssetSchemaValidator::start_object() {
+    if (!on_value(Kind::Object)) return false;
+    depth_++;
+    return true;
+}
+
+bool AssetSchemaValidator::start_array() {
+    if (!on_value(Kind::Array)) return false;
+    depth_++;
+    return true;
+}
+
+bool AssetSchemaValidator::end_object() {
+    depth_--;
+    if (depth_ == 2 && in_item_) {
+        in_item_ = false;
+        for (int i=0;i<3 && !disk_error_;i++) {
+            if (item_[i] != Ok) disk_error_ = kDiskFieldErrors[i];
+        }
+    }
+    return true;
+}
+
+bool AssetSchemaValidator::end_array() {
+    depth_--;
+    if (depth_ == 1) in_disks_ = false;
+    return true;
+}
+
+const char* AssetSchemaValidator::error() const {
+    if (!root_object_) return "root bukan object";
+    for (int i=0;i<9;i++) if (fields_[i] != Ok) return kFieldErrors[i];
+    return disk_error_;
+}
+
+bool validate_asset_json(std::string_view text, std::string& why) {
+    AssetSchemaValidator v;
+    minijson::parse_events(text, v);
+    if (const char* e = v.error()) { why = e; return false; }
+    why.clear();
+    return true;
+}
+
 } // namespace inventory
@@ -1,13 +1,96 @@
 #pragma once
 #include <string>
+#include <vector>
 #include "mini_json.hpp"
 
 namespace inventory {
 
 minijson::Value build_asset_payload(const std::string& agent_version);
 
+// Payload source for a long-running agent. os and cpu_model come from parsing
+// /etc/os-release and /proc/cpuinfo; they are read once and again only when
+// platforminfo::static_facts_stamp() changes or after kFactsMaxAge. The rest
+// (hostname, cores, RAM, disks) is sampled on every collect().
+class AssetCollector {
+public:
+    static constexpr long long kFactsMaxAge = 24 * 3600; // seconds
+
+    explicit AssetCollector(std::string agent_version) : agent_version_(std::move(agent_version)) {}
+
+    minijson::Value collect();
+    int fact_reads() const { return fact_reads_; }
+
+private:
+    std::string agent_version_;
+    std::string os_, cpu_;
+    long long stamp_ = 0;
+    long long read_at_ = 0;
+    int fact_reads_ = 0;
+};
+
 bool validate_asset_schema(const minijson::Value& root, std::string& why);
+bool validate_asset_schema(const minijson::Node& root, std::string& why);
 
 std::string make_asset_id(const std::string& hostname);
 
+// Delta reporting. A payload's version identifies its content apart from
+// timestamp_utc: FNV-1a of its compact JSON (keys sorted), as 16 hex digits.
+// Agent and server compute it the same way, so equal versions mean the
+// server already holds what the agent would send.
+std::string payload_version(const minijson::Value& payload);
+
+// Top-level fields of current that are new or differ from base go to set,
+// fields only in base to unset (asset_id and timestamp_utc are never part of
+// a delta).
+void payload_delta(const minijson::Value& base, const minijson::Value& current,
+                   minijson::Value& set, std::vector<std::string>& unset);
+
+// Applies a delta request {"asset_id","timestamp_utc","base",["set"],["unset"]}
+// to record; without set/unset (a heartbeat) only timestamp_utc changes.
+// timestamp_utc must be "YYYY-MM-DDTHH:MM:SSZ" as the agent writes it. The
+// result still has to pass validate_asset_schema.
+bool apply_delta(minijson::Value& record, const minijson::Node& delta, std::string& why);
+
+// True for a UTC timestamp in the agent's "YYYY-MM-DDTHH:MM:SSZ" form.
+bool valid_timestamp_utc(std::string_view ts);
+
+// Single-pass, allocation-free equivalent of validate_asset_schema driven by
+// minijson::parse_events. Reports the same first error as the tree-based
+// check.
+class AssetSchemaValidator : public minijson::Handler {
+public:
+    bool null_value() override { return on_value(Kind::Other); }
+    bool boolean(bool) override { return on_value(Kind::Other); }
+    bool number(double) override { return on_value(Kind::Number); }
+    bool string(std::string_view) override { return on_value(Kind::String); }
+    bool key(std::string_view k) override;
+    bool start_object() override;
+    bool end_object() override;
+    bool start_array() override;
+    bool end_array() override;
+
+    // Valid once parsing has finished; error() is a static message or null.
+    bool valid() const { return error() == nullptr; }
+    const char* error() const;
+
+private:
+    enum class Kind : unsigned char { Other, Number, String, Object, Array };
+    enum : unsigned char { Missing = 0, WrongType, Ok };
+
+    bool on_value(Kind k);
+
+    int depth_ = 0;
+    bool root_object_ = false;
+    int field_ = -1;                 // top-level field awaiting its value
+    unsigned char fields_[9] = {};   // Missing / WrongType / Ok per top-level field
+    bool in_disks_ = false;
+    bool in_item_ = false;
+    int item_field_ = -1;
+    unsigned char item_[3] = {};
+    const char* disk_error_ = nullptr;
+};
+
+// Validates a JSON text without building a tree; throws on malformed JSON.
+bool validate_asset_json(std::string_view text, std::string& why);
+
 } // namespace inventory
@@ -1,40 +1,484 @@
 #include "logger.hpp"
-#include <fstream>
-#include <iostream>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
 #include <ctime>
 #include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+  #include <signal.h>
+#endif
+
+namespace logutil {
 
-static std::string now_iso() {
-    std::time_t t = std::time(nullptr);
-    std::tm tm{};
+namespace detail { std::atomic<int> min_level{(int)Level::Info}; }
+
+namespace {
+
+const char* level_name(Level l, Format f) {
+    static const char* upper[] = {"DEBUG", "INFO", "WARN", "ERROR", "OFF"};
+    static const char* lower[] = {"debug", "info", "warn", "error", "off"};
+    return (f == Format::Json ? lower : upper)[(int)l];
+}
+
+void append_json_string(std::string& out, std::string_view s) {
+    static const char* hex = "0123456789abcdef";
+    out += '"';
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) { out += "\\u00"; out += hex[c >> 4]; out += hex[c & 15]; }
+                else out += (char)c;
+        }
+    }
+    out += '"';
+}
+
+// Text values are quoted only when they would not read back as one token.
+void append_text_value(std::string& out, const std::string& v, bool quoted) {
+    bool plain = !quoted || (!v.empty() && v.find_first_of(" \t\n\"=") == std::string::npos);
+    if (plain) out += v;
+    else append_json_string(out, v);
+}
+
+// Everything but the timestamp, which the writer prepends: the producer
+// formats, the writer only copies.
+void format_body(std::string& out, Format f, Level level, const std::string& tag, const std::string& msg,
+                 std::initializer_list<Field> fields) {
+    if (f == Format::Json) {
+        out += ",\"level\":\"";
+        out += level_name(level, f);
+        out += "\",\"tag\":";
+        append_json_string(out, tag);
+        out += ",\"msg\":";
+        append_json_string(out, msg);
+        for (const auto& fl : fields) {
+            out += ',';
+            append_json_string(out, fl.key);
+            out += ':';
+            if (fl.quoted) append_json_string(out, fl.value);
+            else out += fl.value;
+        }
+        out += '}';
+    } else {
+        out += '[';
+        out += level_name(level, f);
+        out += "][";
+        out += tag;
+        out += "] ";
+        out += msg;
+        for (const auto& fl : fields) {
+            out += ' ';
+            out += fl.key;
+            out += '=';
+            append_text_value(out, fl.value, fl.quoted);
+        }
+    }
+}
+
+// Line prefix up to the body, formatted once per second: {"ts":"<UTC>" for
+// Json, [local time] for Text.
+class TimestampCache {
+public:
+    explicit TimestampCache(Format f) : format_(f) {}
+
+    const std::string& get(std::time_t t) {
+        if (t != last_ || text_.empty()) {
+            std::tm tm{};
+            char buf[48];
+            if (format_ == Format::Json) {
+#ifdef _WIN32
+                gmtime_s(&tm, &t);
+#else
+                gmtime_r(&t, &tm);
+#endif
+                std::snprintf(buf, sizeof(buf), "{\"ts\":\"%04d-%02d-%02dT%02d:%02d:%02dZ\"",
+                              tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+            } else {
 #ifdef _WIN32
-    localtime_s(&tm, &t);
+                localtime_s(&tm, &t);
 #else
-    localtime_r(&t, &tm);
+                localtime_r(&t, &tm);
 #endif
-    char buf[32];
-    std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d",
-                  tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
-                  tm.tm_hour, tm.tm_min, tm.tm_sec);
-    return buf;
+                std::snprintf(buf, sizeof(buf), "[%04d-%02d-%02d %02d:%02d:%02d]",
+                              tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+            }
+            text_ = buf;
+            last_ = t;
+        }
+        return text_;
+    }
+
+private:
+    Format format_;
+    std::time_t last_ = 0;
+    std::string text_;
+};
+
+void append_line(std::string& out, TimestampCache& ts, std::time_t t, const std::string& body) {
+    out += ts.get(t);
+    out += body;
+    out += '\n';
 }
 
-namespace logutil {
-    void ensure_dirs() {
-        std::filesystem::create_directories("logs");
-        std::filesystem::create_directories("data");
+// The log file with size/age rotation and retention; writer thread only
+// (or under g_init_mu after shutdown).
+class LogFile {
+public:
+    explicit LogFile(const Options& o) : opts_(o) {}
+    ~LogFile() { close(); }
+
+    void write(const std::string& data) {
+        if (data.empty()) return;
+        const std::time_t now = std::time(nullptr);
+        if (!f_) open(now);
+        if (f_ && bytes_ > 0 &&
+            ((opts_.max_bytes && bytes_ + data.size() > opts_.max_bytes) ||
+             (opts_.rotate_seconds > 0 && now - opened_at_ >= opts_.rotate_seconds))) {
+            rotate(now);
+        }
+        if (!f_) return;
+        std::fwrite(data.data(), 1, data.size(), f_);
+        std::fflush(f_);
+        bytes_ += data.size();
+    }
+
+    void close() {
+        if (f_) std::fclose(f_);
+        f_ = nullptr;
+    }
+
+private:
+    void open(std::time_t now) {
+        std::error_code ec;
+        auto dir = std::filesystem::path(opts_.path).parent_path();
+        if (!dir.empty()) std::filesystem::create_directories(dir, ec);
+        f_ = std::fopen(opts_.path.c_str(), "ab");
+        if (!f_) return;
+        auto size = std::filesystem::file_size(opts_.path, ec);
+        bytes_ = ec ? 0 : size;
+        opened_at_ = now;
+    }
+
+    void rotate(std::time_t now) {
+        close();
+        std::tm tm{};
+#ifdef _WIN32
+        gmtime_s(&tm, &now);
+#else
+        gmtime_r(&now, &tm);
+#endif
+        char stamp[32];
+        std::snprintf(stamp, sizeof(stamp), "%04d%02d%02d-%02d%02d%02d",
+                      tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+        std::string target = opts_.path + "." + stamp;
+        std::error_code ec;
+        for (int n = 1; std::filesystem::exists(target, ec); n++) {
+            target = opts_.path + "." + stamp + "-" + std::to_string(n);
+        }
+        std::filesystem::rename(opts_.path, target, ec);
+        prune();
+        open(now);
+    }
+
+    // Rotated names sort by time, so the oldest go first.
+    void prune() {
+        if (opts_.keep_files < 0) return;
+        const std::filesystem::path p(opts_.path);
+        const std::string prefix = p.filename().string() + ".";
+        auto dir = p.parent_path().empty() ? std::filesystem::path(".") : p.parent_path();
+        std::vector<std::filesystem::path> rotated;
+        std::error_code ec;
+        for (const auto& e : std::filesystem::directory_iterator(dir, ec)) {
+            if (e.path().filename().string().rfind(prefix, 0) == 0) rotated.push_back(e.path());
+        }
+        std::sort(rotated.begin(), rotated.end());
+        for (size_t i = 0; i + (size_t)opts_.keep_files < rotated.size(); i++) {
+            std::filesystem::remove(rotated[i], ec);
+        }
+    }
+
+    Options opts_;
+    std::FILE* f_ = nullptr;
+    uint64_t bytes_ = 0;
+    std::time_t opened_at_ = 0;
+};
+
+// Bounded MPSC ring (per-slot sequence numbers, after D. Vyukov's bounded
+// queue). A producer claims a position with one CAS, formats the record
+// into the slot and publishes it through the slot's sequence; the single
+// consumer frees it the same way. Slot strings keep their capacity, so
+// steady-state logging does not allocate.
+class Backend {
+public:
+    explicit Backend(Options opts) : opts_(std::move(opts)), file_(opts_), ts_(opts_.format) {
+        size_t cap = 2;
+        while (cap < opts_.capacity) cap <<= 1;
+        mask_ = cap - 1;
+        slots_.reset(new Slot[cap]);
+        for (size_t i=0;i<cap;i++) slots_[i].seq.store(i, std::memory_order_relaxed);
+#ifndef _WIN32
+        // The writer never handles signals; with all of them blocked it
+        // cannot take one meant for a thread waiting in sigtimedwait.
+        sigset_t all, old;
+        sigfillset(&all);
+        pthread_sigmask(SIG_SETMASK, &all, &old);
+#endif
+        writer_ = std::thread([this] { run(); });
+#ifndef _WIN32
+        pthread_sigmask(SIG_SETMASK, &old, nullptr);
+#endif
+    }
+
+    ~Backend() { stop(); }
+
+    void push(Level level, const std::string& tag, const std::string& msg, std::initializer_list<Field> fields) {
+        const std::time_t t = std::time(nullptr);
+        for (;;) {
+            if (try_push(t, level, tag, msg, fields)) break;
+            if (!opts_.block_when_full || closed_.load(std::memory_order_relaxed)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            wake();
+            std::this_thread::yield();
+        }
+        // The writer only sleeps when the ring was empty; a busy writer is
+        // never signalled, so producers make no syscalls.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed)) wake();
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            if (stopping_) return;
+            stopping_ = true;
+        }
+        closed_.store(true, std::memory_order_relaxed);
+        cv_.notify_one();
+        if (writer_.joinable()) writer_.join();
+        file_.close();
+    }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        std::time_t t = 0;
+        Level level = Level::Info;
+        std::string body; // format_body output
+    };
+
+    bool try_push(std::time_t t, Level level, const std::string& tag, const std::string& msg,
+                  std::initializer_list<Field> fields) {
+        uint64_t pos = head_.load(std::memory_order_relaxed);
+        Slot* s;
+        for (;;) {
+            s = &slots_[pos & mask_];
+            const uint64_t seq = s->seq.load(std::memory_order_acquire);
+            const int64_t dif = (int64_t)(seq - pos);
+            if (dif == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false; // full: the slot still holds a record from one lap ago
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        s->t = t;
+        s->level = level;
+        s->body.clear();
+        format_body(s->body, opts_.format, level, tag, msg, fields);
+        s->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Moves every published record into out (consumer thread only).
+    size_t drain(std::string& out, std::string& errors) {
+        size_t n = 0;
+        for (;;) {
+            Slot& s = slots_[tail_ & mask_];
+            if (s.seq.load(std::memory_order_acquire) != tail_ + 1) break;
+            const size_t at = out.size();
+            append_line(out, ts_, s.t, s.body);
+            if (s.level == Level::Error) errors.append(out, at, std::string::npos);
+            s.seq.store(tail_ + mask_ + 1, std::memory_order_release);
+            tail_++;
+            n++;
+        }
+        return n;
+    }
+
+    void wake() {
+        std::lock_guard<std::mutex> lk(mu_);
+        cv_.notify_one();
+    }
+
+    void flush(const std::string& out, const std::string& errors) {
+        file_.write(out);
+        if (!errors.empty()) std::cerr << errors << std::flush;
+    }
+
+    void run() {
+        std::string out, errors, body;
+        uint64_t reported = 0;
+        for (;;) {
+            out.clear();
+            errors.clear();
+            size_t n = drain(out, errors);
+            const uint64_t d = dropped();
+            if (d != reported) {
+                body.clear();
+                format_body(body, opts_.format, Level::Warn, "logger", "pesan log dibuang (antrean penuh)",
+                            {{"count", d - reported}});
+                append_line(out, ts_, std::time(nullptr), body);
+                reported = d;
+            }
+            flush(out, errors);
+            if (n) continue;
+
+            std::unique_lock<std::mutex> lk(mu_);
+            if (stopping_) {
+                lk.unlock();
+                out.clear();
+                errors.clear();
+                if (drain(out, errors) == 0) return;
+                flush(out, errors);
+                continue;
+            }
+            sleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const Slot& s = slots_[tail_ & mask_];
+            // A producer publishing after this check sees sleeping_ and
+            // notifies under mu_, which we hold until wait() releases it.
+            if (s.seq.load(std::memory_order_acquire) != tail_ + 1) cv_.wait(lk);
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    Options opts_;
+    LogFile file_;                    // writer thread only
+    TimestampCache ts_;               // writer thread only
+    std::unique_ptr<Slot[]> slots_;
+    uint64_t mask_ = 0;
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) uint64_t tail_ = 0;   // writer thread only
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> closed_{false};
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::thread writer_;
+};
+
+std::mutex g_init_mu;
+Options g_options;
+std::atomic<Backend*> g_backend{nullptr};
+Backend* g_retired = nullptr;         // after shutdown(), for dropped()
+bool g_stopped = false;               // guarded by g_init_mu
+
+// After shutdown(): formatted and written by the caller.
+void write_sync(Level level, const std::string& tag, const std::string& msg, std::initializer_list<Field> fields) {
+    std::lock_guard<std::mutex> lk(g_init_mu);
+    static LogFile file(g_options);
+    static TimestampCache ts(g_options.format);
+    std::string body, line;
+    format_body(body, g_options.format, level, tag, msg, fields);
+    append_line(line, ts, std::time(nullptr), body);
+    file.write(line);
+    if (level == Level::Error) std::cerr << line;
+}
+
+// Never destroyed: shutdown() (via atexit) drains and joins the writer, and
+// objects logging from their own static destructors afterwards fall back to
+// write_sync.
+Backend* backend() {
+    Backend* b = g_backend.load(std::memory_order_acquire);
+    if (b) return b;
+    std::lock_guard<std::mutex> lk(g_init_mu);
+    if (g_stopped) return nullptr;
+    b = g_backend.load(std::memory_order_relaxed);
+    if (!b) {
+        b = new Backend(g_options);
+        g_backend.store(b, std::memory_order_release);
+        std::atexit(shutdown);
     }
+    return b;
+}
+
+} // namespace
+
+void ensure_dirs() {
+    std::filesystem::create_directories("logs");
+    std::filesystem::create_directories("data");
+}
+
+void log(Level level, const std::string& tag, const std::string& msg, std::initializer_list<Field> fields) {
+    if (!enabled(level)) return;
+    if (Backend* b = backend()) b->push(level, tag, msg, fields);
+    else write_sync(level, tag, msg, fields);
+}
+
+void log(Level level, const std::string& tag, const std::string& msg) { log(level, tag, msg, {}); }
 
-    static void write(const std::string& level, const std::string& tag, const std::string& msg) {
-        ensure_dirs();
-        std::string line = "[" + now_iso() + "][" + level + "][" + tag + "] " + msg;
-        std::ofstream f("logs/app.log", std::ios::app);
-        f << line << "\n";
-        // also print to stderr for visibility
-        if (level == "ERROR") std::cerr << line << "\n";
+void info(const std::string& tag, const std::string& msg) { log(Level::Info, tag, msg); }
+void warn(const std::string& tag, const std::string& msg) { log(Level::Warn, tag, msg); }
+void error(const std::string& tag, const std::string& msg) { log(Level::Error, tag, msg); }
+
+void set_level(Level l) { detail::min_level.store((int)l, std::memory_order_relaxed); }
+
+bool parse_level(std::string_view s, Level& out) {
+    static const struct { const char* name; Level level; } names[] = {
+        {"debug", Level::Debug}, {"info", Level::Info}, {"warn", Level::Warn},
+        {"error", Level::Error}, {"off", Level::Off},
+    };
+    for (const auto& n : names) {
+        if (s == n.name) { out = n.level; return true; }
+    }
+    return false;
+}
+
+bool configure(const Options& opts) {
+    set_level(opts.level);
+    std::lock_guard<std::mutex> lk(g_init_mu);
+    if (g_backend.load(std::memory_order_relaxed) || g_stopped) return false;
+    g_options = opts;
+    return true;
+}
+
+void shutdown() {
+    Backend* b;
+    {
+        std::lock_guard<std::mutex> lk(g_init_mu);
+        g_stopped = true;
+        b = g_backend.exchange(nullptr);
+        if (b) g_retired = b;
     }
+    // The Backend stays allocated: a producer may still hold the pointer.
+    if (b) b->stop();
+}
 
-    void info(const std::string& tag, const std::string& msg) { write("INFO", tag, msg); }
-    void warn(const std::string& tag, const std::string& msg) { write("WARN", tag, msg); }
-    void error(const std::string& tag, const std::string& msg) { write("ERROR", tag, msg); }
+uint64_t dropped() {
+    Backend* b = g_backend.load(std::memory_order_acquire);
+    if (!b) {
+        std::lock_guard<std::mutex> lk(g_init_mu);
+        b = g_retired;
+    }
+    return b ? b->dropped() : 0;
 }
+
+} // namespace logutil
@@ -1,9 +1,92 @@
 #pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <string>
+#include <string_view>
+#include <type_traits>
+
+// Lowest level compiled into LOGUTIL() call sites: 0 debug, 1 info, 2 warn,
+// 3 error (set from CMake, ASSET_INVENTORY_LOG_LEVEL).
+#ifndef ASSET_INVENTORY_LOG_LEVEL
+#define ASSET_INVENTORY_LOG_LEVEL 0
+#endif
 
 namespace logutil {
+    enum class Level : int { Debug = 0, Info, Warn, Error, Off };
+    enum class Format { Json, Text };
+
     void ensure_dirs();
     void info(const std::string& tag, const std::string& msg);
     void warn(const std::string& tag, const std::string& msg);
     void error(const std::string& tag, const std::string& msg);
+
+    // One key/value of a structured record; numbers are written unquoted.
+    struct Field {
+        Field(const char* k, std::string_view v) : key(k), value(v), quoted(true) {}
+        Field(const char* k, const std::string& v) : key(k), value(v), quoted(true) {}
+        Field(const char* k, const char* v) : key(k), value(v), quoted(true) {}
+        template <class T, class = std::enable_if_t<std::is_arithmetic_v<T>>>
+        Field(const char* k, T v) : key(k), value(std::to_string(v)), quoted(false) {}
+        Field(const char* k, bool v) : key(k), value(v ? "true" : "false"), quoted(false) {}
+
+        const char* key;
+        std::string value;
+        bool quoted;
+    };
+
+    void log(Level level, const std::string& tag, const std::string& msg);
+    void log(Level level, const std::string& tag, const std::string& msg, std::initializer_list<Field> fields);
+
+    namespace detail { extern std::atomic<int> min_level; }
+
+    // Compile-time and runtime threshold; one relaxed load.
+    inline bool enabled(Level l) {
+        return (int)l >= ASSET_INVENTORY_LOG_LEVEL &&
+               (int)l >= detail::min_level.load(std::memory_order_relaxed);
+    }
+
+    void set_level(Level l);
+    // "debug", "info", "warn", "error", "off"
+    bool parse_level(std::string_view s, Level& out);
+
+    // Messages are queued in a bounded lock-free ring and written by a
+    // background thread to a file it keeps open; ERROR lines also go to
+    // stderr from that thread. The writer starts with the first message.
+    struct Options {
+        std::string path = "logs/app.log";
+        size_t capacity = 8192;        // queued messages, rounded up to a power of two
+        bool block_when_full = false;  // false: drop (and count) when the ring is full
+        Level level = Level::Info;
+        // Json: {"ts":"<UTC>","level":..,"tag":..,"msg":..,<fields>} per line.
+        // Text: [local time][LEVEL][tag] msg key=value ...
+        Format format = Format::Json;
+        // The file is renamed to <path>.<UTC YYYYmmdd-HHMMSS> once it would
+        // grow past max_bytes or is older than rotate_seconds (0 = off), and
+        // only the newest keep_files of those are kept.
+        uint64_t max_bytes = 10ull << 20;
+        int64_t rotate_seconds = 0;
+        int keep_files = 5;            // < 0: keep all
+    };
+
+    // Takes effect only before the first message; returns false afterwards.
+    // The level is applied either way (see set_level).
+    bool configure(const Options& opts);
+
+    // Writes everything queued so far and stops the writer; later messages
+    // are written synchronously. Also registered with atexit.
+    void shutdown();
+
+    // Messages dropped because the ring was full.
+    uint64_t dropped();
 }
+
+// LOGUTIL(Info, "server", "index loaded", {{"assets", n}}): the message and
+// fields are only built when the level is enabled, and levels below
+// ASSET_INVENTORY_LOG_LEVEL compile to nothing.
+#define LOGUTIL(level, ...)                                                   \
+    do {                                                                      \
+        if (logutil::enabled(logutil::Level::level))                          \
+            logutil::log(logutil::Level::level, __VA_ARGS__);                 \
+    } while (0)
@@ -0,0 +1,168 @@
+#include "metrics.hpp"
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace metrics {
+
+namespace detail { std::atomic<bool> on{true}; }
+
+namespace {
+
+// Upper bucket bounds in nanoseconds, 1 us .. 1 s; one more bucket holds
+// everything slower (+Inf).
+constexpr uint64_t kBounds[] = {
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 5000000, 10000000, 25000000, 50000000, 100000000, 250000000, 1000000000,
+};
+constexpr int kBuckets = sizeof(kBounds) / sizeof(kBounds[0]) + 1;
+
+// Status codes the server answers with; anything else lands in the last slot.
+constexpr int kStatuses[] = {200, 201, 304, 400, 404, 409, 413, 500};
+constexpr int kStatusSlots = sizeof(kStatuses) / sizeof(kStatuses[0]) + 1;
+
+constexpr int kStages = (int)Stage::Count;
+constexpr int kRoutes = (int)Route::Count;
+
+const char* const kStageNames[kStages] = {"accept", "read_request", "json_parse", "validate", "append", "send"};
+const char* const kRouteNames[kRoutes] = {
+    "dashboard", "assets", "assets_query", "export_csv", "stats", "metrics",
+    "post_asset", "batch", "delta", "other",
+};
+
+// Written only by its own thread; the atomics let render() read it
+// concurrently. inc() is a load and a store, not a read-modify-write.
+struct Shard {
+    struct Histogram {
+        std::atomic<uint64_t> buckets[kBuckets];
+        std::atomic<uint64_t> sum_ns;
+    };
+    Histogram stages[kStages];
+    std::atomic<uint64_t> requests[kRoutes][kStatusSlots];
+
+    Shard() {
+        for (auto& h : stages) {
+            for (auto& b : h.buckets) b.store(0, std::memory_order_relaxed);
+            h.sum_ns.store(0, std::memory_order_relaxed);
+        }
+        for (auto& r : requests) {
+            for (auto& c : r) c.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static void add(std::atomic<uint64_t>& c, uint64_t n) {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+// Shards outlive their threads, so counts from finished workers (bench_load
+// runs the server more than once) stay in the totals.
+std::mutex g_shards_mu;
+std::vector<std::unique_ptr<Shard>> g_shards;
+
+Shard& shard() {
+    thread_local Shard* s = nullptr;
+    if (!s) {
+        auto owned = std::make_unique<Shard>();
+        s = owned.get();
+        std::lock_guard<std::mutex> lk(g_shards_mu);
+        g_shards.push_back(std::move(owned));
+    }
+    return *s;
+}
+
+int bucket_of(uint64_t ns) {
+    int i = 0;
+    while (i < kBuckets - 1 && ns > kBounds[i]) i++;
+    return i;
+}
+
+int status_slot(int status) {
+    for (int i=0;i<kStatusSlots - 1;i++) {
+        if (kStatuses[i] == status) return i;
+    }
+    return kStatusSlots - 1;
+}
+
+void append_seconds(std::string& out, uint64_t ns) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", (double)ns / 1e9);
+    out += buf;
+}
+
+} // namespace
+
+void set_enabled(bool on) { detail::on.store(on, std::memory_order_relaxed); }
+
+void observe(Stage stage, uint64_t ns) {
+    auto& h = shard().stages[(int)stage];
+    Shard::add(h.buckets[bucket_of(ns)], 1);
+    Shard::add(h.sum_ns, ns);
+}
+
+void count_request(Route route, int status) {
+    if (!enabled()) return;
+    Shard::add(shard().requests[(int)route][status_slot(status)], 1);
+}
+
+std::string render() {
+    uint64_t buckets[kStages][kBuckets] = {};
+    uint64_t sums[kStages] = {};
+    uint64_t requests[kRoutes][kStatusSlots] = {};
+    {
+        std::lock_guard<std::mutex> lk(g_shards_mu);
+        for (const auto& s : g_shards) {
+            for (int st=0;st<kStages;st++) {
+                for (int b=0;b<kBuckets;b++) buckets[st][b] += s->stages[st].buckets[b].load(std::memory_order_relaxed);
+                sums[st] += s->stages[st].sum_ns.load(std::memory_order_relaxed);
+            }
+            for (int r=0;r<kRoutes;r++) {
+                for (int c=0;c<kStatusSlots;c++) requests[r][c] += s->requests[r][c].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::string out;
+    out.reserve(16384);
+    char line[160];
+    out += "# HELP asset_server_http_requests_total HTTP requests answered, by route and status code.\n"
+           "# TYPE asset_server_http_requests_total counter\n";
+    for (int r=0;r<kRoutes;r++) {
+        for (int c=0;c<kStatusSlots;c++) {
+            if (!requests[r][c]) continue;
+            char code[8];
+            if (c < kStatusSlots - 1) std::snprintf(code, sizeof(code), "%d", kStatuses[c]);
+            else std::snprintf(code, sizeof(code), "other");
+            std::snprintf(line, sizeof(line), "asset_server_http_requests_total{route=\"%s\",code=\"%s\"} %llu\n",
+                          kRouteNames[r], code, (unsigned long long)requests[r][c]);
+            out += line;
+        }
+    }
+
+    out += "# HELP asset_server_stage_duration_seconds Time spent in one request stage.\n"
+           "# TYPE asset_server_stage_duration_seconds histogram\n";
+    for (int st=0;st<kStages;st++) {
+        uint64_t cumulative = 0;
+        for (int b=0;b<kBuckets;b++) {
+            cumulative += buckets[st][b];
+            out += "asset_server_stage_duration_seconds_bucket{stage=\"";
+            out += kStageNames[st];
+            out += "\",le=\"";
+            if (b < kBuckets - 1) append_seconds(out, kBounds[b]);
+            else out += "+Inf";
+            std::snprintf(line, sizeof(line), "\"} %llu\n", (unsigned long long)cumulative);
+            out += line;
+        }
+        out += "asset_server_stage_duration_seconds_sum{stage=\"";
+        out += kStageNames[st];
+        out += "\"} ";
+        append_seconds(out, sums[st]);
+        std::snprintf(line, sizeof(line), "\nasset_server_stage_duration_seconds_count{stage=\"%s\"} %llu\n",
+                      kStageNames[st], (unsigned long long)cumulative);
+        out += line;
+    }
+    return out;
+}
+
+} // namespace metrics
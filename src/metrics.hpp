@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Server instrumentation: request counters per route and status, and
+// fixed-bucket latency histograms for the request stages. Every thread
+// updates its own shard with plain relaxed stores (no shared cache lines,
+// no locked instructions); render() sums the shards when /metrics is
+// scraped, so a scrape may miss increments that are in flight.
+namespace metrics {
+
+enum class Stage : int {
+    Accept,      // accept4 + registering the connection (epoll mode)
+    ReadRequest, // first byte of a request until it is parsed (the blocking read in single-thread mode)
+    JsonParse,   // minijson parse of a POST body / batch item
+    Validate,    // inventory::validate_asset_schema
+    Append,      // filestore::AppendWriter append (includes a shared fsync)
+    Send,        // one sendmsg / send_all
+    Count
+};
+
+enum class Route : int {
+    Dashboard,   // GET /
+    Assets,      // GET /api/assets
+    AssetsQuery, // GET /api/assets?...
+    ExportCsv,   // GET /export.csv
+    Stats,       // GET /api/stats
+    Metrics,     // GET /metrics
+    Post,        // POST /api/assets
+    Batch,       // POST /api/assets/batch
+    Delta,       // POST /api/assets/delta
+    Other,       // unknown path or unparseable request
+    Count
+};
+
+namespace detail { extern std::atomic<bool> on; }
+
+// Collection is on by default; when off, Timer makes no clock reads.
+void set_enabled(bool on);
+inline bool enabled() { return detail::on.load(std::memory_order_relaxed); }
+
+void observe(Stage stage, uint64_t ns);
+void count_request(Route route, int status);
+
+// Prometheus text exposition format (0.0.4).
+std::string render();
+
+inline uint64_t now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Observes the time from construction to destruction (or stop()).
+class Timer {
+public:
+    explicit Timer(Stage stage) : stage_(stage), t0_(enabled() ? now_ns() : 0) {}
+    ~Timer() { stop(); }
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    void stop() {
+        if (t0_) observe(stage_, now_ns() - t0_);
+        t0_ = 0;
+    }
+
+private:
+    Stage stage_;
+    uint64_t t0_;
+};
+
+} // namespace metrics
@@ -1,6 +1,7 @@
 #include "mini_json.hpp"
-#include <sstream>
-#include <iomanip>
+#include <charconv>
+#include <cstring>
+#include <cmath>
 
 namespace minijson {
 
@@ -13,13 +14,258 @@ bool Value::has(const std::string& k) const {
     return o.find(k) != o.end();
 }
 
+// ---------------------------------------------------------------------------
+// Byte scanning. Strings and whitespace runs are scanned 16 (SSE2) or 32
+// (AVX2) bytes at a time; the implementation is picked once at startup from
+// the CPU's capabilities, with a portable scalar fallback.
+
+static bool is_string_stop(unsigned char c) { return c == '"' || c == '\\' || c < 0x20; }
+static bool is_json_ws(unsigned char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+static size_t string_span_scalar(const char* p, const char* end) {
+    const char* s = p;
+    while (p < end && !is_string_stop((unsigned char)*p)) p++;
+    return (size_t)(p - s);
+}
+
+static size_t ws_span_scalar(const char* p, const char* end) {
+    const char* s = p;
+    while (p < end && is_json_ws((unsigned char)*p)) p++;
+    return (size_t)(p - s);
+}
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+  #define MINIJSON_HAVE_SSE2 1
+  #include <emmintrin.h>
+#endif
+#if defined(MINIJSON_HAVE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+  #define MINIJSON_HAVE_AVX2 1
+  #include <immintrin.h>
+#endif
+
+#ifdef MINIJSON_HAVE_SSE2
+#ifdef _MSC_VER
+  #include <intrin.h>
+#endif
+static inline unsigned ctz32(unsigned m) {
+#ifdef _MSC_VER
+    unsigned long r; _BitScanForward(&r, m); return (unsigned)r;
+#else
+    return (unsigned)__builtin_ctz(m);
+#endif
+}
+
+static size_t string_span_sse2(const char* p, const char* end) {
+    const char* s = p;
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i bslash = _mm_set1_epi8('\\');
+    const __m128i ctl = _mm_set1_epi8(0x1f);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        // unsigned v <= 0x1f  <=>  min(v, 0x1f) == v
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash)),
+                                 _mm_cmpeq_epi8(_mm_min_epu8(v, ctl), v));
+        unsigned mask = (unsigned)_mm_movemask_epi8(m);
+        if (mask) return (size_t)(p - s) + ctz32(mask);
+        p += 16;
+    }
+    return (size_t)(p - s) + string_span_scalar(p, end);
+}
+
+static size_t ws_span_sse2(const char* p, const char* end) {
+    const char* s = p;
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                                 _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+        unsigned mask = ~(unsigned)_mm_movemask_epi8(m) & 0xffffu;
+        if (mask) return (size_t)(p - s) + ctz32(mask);
+        p += 16;
+    }
+    return (size_t)(p - s) + ws_span_scalar(p, end);
+}
+#endif
+
+#ifdef MINIJSON_HAVE_AVX2
+__attribute__((target("avx2")))
+static size_t string_span_avx2(const char* p, const char* end) {
+    const char* s = p;
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i bslash = _mm256_set1_epi8('\\');
+    const __m256i ctl = _mm256_set1_epi8(0x1f);
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, bslash)),
+                                    _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctl), v));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+        if (mask) return (size_t)(p - s) + ctz32(mask);
+        p += 32;
+    }
+    return (size_t)(p - s) + string_span_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+static size_t ws_span_avx2(const char* p, const char* end) {
+    const char* s = p;
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))));
+        unsigned mask = ~(unsigned)_mm256_movemask_epi8(m);
+        if (mask) return (size_t)(p - s) + ctz32(mask);
+        p += 32;
+    }
+    return (size_t)(p - s) + ws_span_sse2(p, end);
+}
+#endif
+
+struct ScanFns {
+    ScanImpl impl;
+    size_t (*string_span)(const char*, const char*);
+    size_t (*ws_span)(const char*, const char*);
+};
+
+static ScanFns scan_fns_for(ScanImpl impl) {
+    switch (impl) {
+#ifdef MINIJSON_HAVE_AVX2
+        case ScanImpl::AVX2: return {ScanImpl::AVX2, string_span_avx2, ws_span_avx2};
+#endif
+#ifdef MINIJSON_HAVE_SSE2
+        case ScanImpl::SSE2: return {ScanImpl::SSE2, string_span_sse2, ws_span_sse2};
+#endif
+        default: return {ScanImpl::Scalar, string_span_scalar, ws_span_scalar};
+    }
+}
+
+static bool scan_impl_supported(ScanImpl impl) {
+    switch (impl) {
+        case ScanImpl::Scalar: return true;
+#ifdef MINIJSON_HAVE_SSE2
+        case ScanImpl::SSE2: return true;
+#endif
+#ifdef MINIJSON_HAVE_AVX2
+        case ScanImpl::AVX2: return __builtin_cpu_supports("avx2");
+#endif
+        default: return false;
+    }
+}
+
+static ScanFns detect_scan_fns() {
+#ifdef MINIJSON_HAVE_AVX2
+    __builtin_cpu_init(); // may run before libgcc's own initialiser
+#endif
+    for (ScanImpl impl : {ScanImpl::AVX2, ScanImpl::SSE2}) {
+        if (scan_impl_supported(impl)) return scan_fns_for(impl);
+    }
+    return scan_fns_for(ScanImpl::Scalar);
+}
+
+// Probed on first use rather than during static initialisation, so that
+// parsing from another translation unit's static initialiser is safe.
+static ScanFns& scan_fns() {
+    static ScanFns fns = detect_scan_fns();
+    return fns;
+}
+
+ScanImpl scan_impl() { return scan_fns().impl; }
+
+bool set_scan_impl(ScanImpl impl) {
+    if (!scan_impl_supported(impl)) return false;
+    scan_fns() = scan_fns_for(impl);
+    return true;
+}
+
+const char* scan_impl_name(ScanImpl impl) {
+    switch (impl) {
+        case ScanImpl::Scalar: return "scalar";
+        case ScanImpl::SSE2: return "sse2";
+        case ScanImpl::AVX2: return "avx2";
+    }
+    return "?";
+}
+
+// Skips whitespace from t[i]. Short runs (the common case in compact JSON)
+// are handled inline; \v and \f are still accepted as before.
+static void skip_ws(std::string_view t, size_t& i) {
+    while (i < t.size()) {
+        unsigned char c = (unsigned char)t[i];
+        if (!std::isspace(c)) return;
+        if (c == '\v' || c == '\f') { i++; continue; }
+        i += scan_fns().ws_span(t.data() + i, t.data() + t.size());
+    }
+}
+
+// Decodes the rest of a string whose opening quote has been consumed,
+// appending to out; leaves i after the closing quote. Unescaped spans are
+// copied in bulk.
+static void read_string_body(std::string_view t, size_t& i, std::string& out) {
+    while (i < t.size()) {
+        size_t n = scan_fns().string_span(t.data() + i, t.data() + t.size());
+        out.append(t.data() + i, n);
+        i += n;
+        if (i >= t.size()) break;
+        char c = t[i++];
+        if (c == '"') return;
+        if (c != '\\') { out.push_back(c); continue; } // raw control character, accepted as before
+        char e = i < t.size() ? t[i++] : '\0';
+        switch (e) {
+            case '"': out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/': out.push_back('/'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                // minimal \uXXXX support -> store as '?'
+                for (int k=0;k<4;k++) {
+                    if (i >= t.size() || !std::isxdigit((unsigned char)t[i++])) throw std::runtime_error("bad \\u escape");
+                }
+                out.push_back('?');
+                break;
+            }
+            default: throw std::runtime_error("bad escape");
+        }
+    }
+    throw std::runtime_error("unterminated string");
+}
+
+// Nesting limit shared by all three parsers: they recurse per array /
+// object, so unbounded input like [[[[... would overflow the stack.
+static constexpr int kMaxDepth = 512;
+
+static void enter_container(int& depth) {
+    if (++depth > kMaxDepth) throw std::runtime_error("nesting too deep");
+}
+
+// Scans a JSON number at t[i] and converts it with std::from_chars.
+static double read_number(std::string_view t, size_t& i) {
+    size_t start = i;
+    auto digits = [&]{ while (i < t.size() && std::isdigit((unsigned char)t[i])) i++; };
+    if (i < t.size() && t[i] == '-') i++;
+    digits();
+    if (i < t.size() && t[i] == '.') { i++; digits(); }
+    if (i < t.size() && (t[i] == 'e' || t[i] == 'E')) {
+        i++;
+        if (i < t.size() && (t[i] == '+' || t[i] == '-')) i++;
+        digits();
+    }
+    double d = 0;
+    auto r = std::from_chars(t.data() + start, t.data() + i, d);
+    if (r.ec != std::errc() || r.ptr != t.data() + i) throw std::runtime_error("bad number");
+    return d;
+}
+
 struct Parser {
-    const std::string& t;
+    std::string_view t;
     size_t i = 0;
+    int depth = 0;
 
-    explicit Parser(const std::string& s): t(s) {}
+    explicit Parser(std::string_view s): t(s) {}
 
-    void ws() { while (i < t.size() && std::isspace((unsigned char)t[i])) i++; }
+    void ws() { skip_ws(t, i); }
     char peek() { ws(); return (i < t.size()) ? t[i] : '\0'; }
     char get() { if (i >= t.size()) return '\0'; return t[i++]; }
 
@@ -52,55 +298,21 @@ struct Parser {
         ws();
         if (get() != '"') throw std::runtime_error("expected string quote");
         std::string out;
-        while (i < t.size()) {
-            char c = get();
-            if (c == '"') break;
-            if (c == '\\') {
-                char e = get();
-                switch (e) {
-                    case '"': out.push_back('"'); break;
-                    case '\\': out.push_back('\\'); break;
-                    case '/': out.push_back('/'); break;
-                    case 'b': out.push_back('\b'); break;
-                    case 'f': out.push_back('\f'); break;
-                    case 'n': out.push_back('\n'); break;
-                    case 'r': out.push_back('\r'); break;
-                    case 't': out.push_back('\t'); break;
-                    case 'u': {
-                        // minimal \uXXXX support -> store as '?'
-                        for (int k=0;k<4;k++) { if (!std::isxdigit((unsigned char)get())) throw std::runtime_error("bad \\u escape"); }
-                        out.push_back('?');
-                        break;
-                    }
-                    default: throw std::runtime_error("bad escape");
-                }
-            } else {
-                out.push_back(c);
-            }
-        }
+        read_string_body(t, i, out);
         return out;
     }
 
     double parse_number() {
         ws();
-        size_t start = i;
-        if (peek() == '-') get();
-        while (std::isdigit((unsigned char)peek())) get();
-        if (peek() == '.') { get(); while (std::isdigit((unsigned char)peek())) get(); }
-        if (peek() == 'e' || peek() == 'E') {
-            get();
-            if (peek() == '+' || peek() == '-') get();
-            while (std::isdigit((unsigned char)peek())) get();
-        }
-        std::string sub = t.substr(start, i - start);
-        try { return std::stod(sub); } catch (...) { throw std::runtime_error("bad number"); }
+        return read_number(t, i);
     }
 
     Value parse_array() {
         expect('[');
+        enter_container(depth);
         std::vector<Value> arr;
         ws();
-        if (peek() == ']') { get(); return Value::array(std::move(arr)); }
+        if (peek() == ']') { get(); depth--; return Value::array(std::move(arr)); }
         while (true) {
             arr.push_back(parse_value());
             ws();
@@ -108,14 +320,16 @@ struct Parser {
             if (c == ']') break;
             if (c != ',') throw std::runtime_error("expected , or ]");
         }
+        depth--;
         return Value::array(std::move(arr));
     }
 
     Value parse_object() {
         expect('{');
+        enter_container(depth);
         std::map<std::string, Value> obj;
         ws();
-        if (peek() == '}') { get(); return Value::object(std::move(obj)); }
+        if (peek() == '}') { get(); depth--; return Value::object(std::move(obj)); }
         while (true) {
             std::string key = parse_string();
             ws();
@@ -127,6 +341,7 @@ struct Parser {
             if (c == '}') break;
             if (c != ',') throw std::runtime_error("expected , or }");
         }
+        depth--;
         return Value::object(std::move(obj));
     }
 };
@@ -142,74 +357,476 @@ Value parse(const std::string& text) {
     return v;
 }
 
-static std::string esc(const std::string& s) {
-    std::ostringstream o;
-    for (char c: s) {
-        switch (c) {
-            case '"': o << "\\\""; break;
-            case '\\': o << "\\\\"; break;
-            case '\b': o << "\\b"; break;
-            case '\f': o << "\\f"; break;
-            case '\n': o << "\\n"; break;
-            case '\r': o << "\\r"; break;
-            case '\t': o << "\\t"; break;
-            default:
-                if ((unsigned char)c < 0x20) o << "?";
-                else o << c;
-        }
+// ---------------------------------------------------------------------------
+// Writer
+
+// Replacement after a backslash for characters that need escaping; '?' means
+// the character itself is written as '?' (other control characters).
+// constexpr, so it is constant-initialised and usable from other
+// translation units' static initialisers.
+struct EscapeTable {
+    char map[256] = {};
+    constexpr EscapeTable() {
+        for (int c=0;c<0x20;c++) map[c] = '?';
+        map[(unsigned char)'"'] = '"';
+        map[(unsigned char)'\\'] = '\\';
+        map[(unsigned char)'\b'] = 'b';
+        map[(unsigned char)'\f'] = 'f';
+        map[(unsigned char)'\n'] = 'n';
+        map[(unsigned char)'\r'] = 'r';
+        map[(unsigned char)'\t'] = 't';
     }
-    return o.str();
+};
+static constexpr EscapeTable kEscape;
+
+Writer::Writer(std::string& out, bool pretty, int indent)
+    : out_(out), pretty_(pretty), base_indent_(indent) {}
+
+void Writer::spaces(int n) { out_.append((size_t)n, ' '); }
+
+void Writer::write_string(std::string_view s) {
+    out_ += '"';
+    const char* p = s.data();
+    const char* end = p + s.size();
+    while (p < end) {
+        // the scanner's stop set is exactly the set of characters to escape
+        size_t n = scan_fns().string_span(p, end);
+        out_.append(p, n);
+        p += n;
+        if (p >= end) break;
+        char e = kEscape.map[(unsigned char)*p++];
+        if (e == '?') { out_ += '?'; continue; }
+        out_ += '\\';
+        out_ += e;
+    }
+    out_ += '"';
 }
 
-static void indent(std::ostringstream& o, int n) { for (int i=0;i<n;i++) o << ' '; }
+void Writer::write_number(double d) {
+    // Same text as ostream << setprecision(15), i.e. printf("%.15g").
+    char buf[32];
+    std::to_chars_result r;
+    if (d > -1e15 && d < 1e15 && d == (double)(long long)d && !(d == 0 && std::signbit(d))) {
+        r = std::to_chars(buf, buf + sizeof(buf), (long long)d);
+    } else {
+        r = std::to_chars(buf, buf + sizeof(buf), d, std::chars_format::general, 15);
+    }
+    out_.append(buf, (size_t)(r.ptr - buf));
+}
 
-std::string stringify(const Value& v, bool pretty, int indent_level) {
-    std::ostringstream o;
+void Writer::write(const Value& v, int ind) {
     switch (v.type) {
-        case Value::Type::Null: o << "null"; break;
-        case Value::Type::Bool: o << (v.b ? "true" : "false"); break;
-        case Value::Type::Number: {
-            o << std::setprecision(15) << v.num;
+        case Value::Type::Null: out_ += "null"; break;
+        case Value::Type::Bool: out_ += v.b ? "true" : "false"; break;
+        case Value::Type::Number: write_number(v.num); break;
+        case Value::Type::String: write_string(v.s); break;
+        case Value::Type::Array: {
+            out_ += '[';
+            if (v.a.empty()) { out_ += ']'; break; }
+            for (size_t i=0;i<v.a.size(); ++i) {
+                if (i) out_ += ',';
+                if (pretty_) { out_ += '\n'; spaces(ind + 2); }
+                write(v.a[i], ind + 2);
+            }
+            if (pretty_) { out_ += '\n'; spaces(ind); }
+            out_ += ']';
             break;
         }
-        case Value::Type::String:
-            o << "\"" << esc(v.s) << "\"";
+        case Value::Type::Object: {
+            out_ += '{';
+            if (v.o.empty()) { out_ += '}'; break; }
+            bool first = true;
+            for (const auto& kv : v.o) {
+                if (!first) out_ += ',';
+                first = false;
+                if (pretty_) { out_ += '\n'; spaces(ind + 2); }
+                write_string(kv.first);
+                out_ += pretty_ ? ": " : ":";
+                write(kv.second, ind + 2);
+            }
+            if (pretty_) { out_ += '\n'; spaces(ind); }
+            out_ += '}';
             break;
+        }
+    }
+}
+
+void Writer::write(const Node& v, int ind) {
+    switch (v.type) {
+        case Value::Type::Null: out_ += "null"; break;
+        case Value::Type::Bool: out_ += v.b ? "true" : "false"; break;
+        case Value::Type::Number: write_number(v.num); break;
+        case Value::Type::String: write_string(v.string()); break;
         case Value::Type::Array: {
-            o << "[";
-            if (!v.a.empty()) {
-                if (pretty) o << "\n";
-                for (size_t i=0;i<v.a.size(); ++i) {
-                    if (pretty) indent(o, indent_level + 2);
-                    o << stringify(v.a[i], pretty, indent_level + 2);
-                    if (i + 1 < v.a.size()) o << ",";
-                    if (pretty) o << "\n";
-                }
-                if (pretty) indent(o, indent_level);
+            out_ += '[';
+            if (!v.len) { out_ += ']'; break; }
+            for (size_t i=0;i<v.len; ++i) {
+                if (i) out_ += ',';
+                if (pretty_) { out_ += '\n'; spaces(ind + 2); }
+                write(v.items[i], ind + 2);
             }
-            o << "]";
+            if (pretty_) { out_ += '\n'; spaces(ind); }
+            out_ += ']';
             break;
         }
         case Value::Type::Object: {
-            o << "{";
-            if (!v.o.empty()) {
-                if (pretty) o << "\n";
-                size_t n=0;
-                for (const auto& kv: v.o) {
-                    if (pretty) indent(o, indent_level + 2);
-                    o << "\"" << esc(kv.first) << "\":";
-                    if (pretty) o << " ";
-                    o << stringify(kv.second, pretty, indent_level + 2);
-                    if (++n < v.o.size()) o << ",";
-                    if (pretty) o << "\n";
-                }
-                if (pretty) indent(o, indent_level);
+            out_ += '{';
+            if (!v.len) { out_ += '}'; break; }
+            for (size_t i=0;i<v.len; ++i) {
+                if (i) out_ += ',';
+                if (pretty_) { out_ += '\n'; spaces(ind + 2); }
+                write_string(v.members[i].key);
+                out_ += pretty_ ? ": " : ":";
+                write(v.members[i].value, ind + 2);
             }
-            o << "}";
+            if (pretty_) { out_ += '\n'; spaces(ind); }
+            out_ += '}';
             break;
         }
     }
-    return o.str();
+}
+
+void Writer::value(const Value& v) { before_value(); write(v, current_indent()); }
+void Writer::value(const Node& v) { before_value(); write(v, current_indent()); }
+
+void Writer::null_value() { before_value(); out_ += "null"; }
+void Writer::boolean(bool b) { before_value(); out_ += b ? "true" : "false"; }
+void Writer::number(double d) { before_value(); write_number(d); }
+void Writer::string(std::string_view s) { before_value(); write_string(s); }
+
+int Writer::current_indent() const { return base_indent_ + 2 * (int)levels_.size(); }
+
+void Writer::before_value() {
+    if (after_key_) { after_key_ = false; return; }
+    if (levels_.empty()) return;
+    if (levels_.back()) out_ += ',';
+    levels_.back() = 1;
+    if (pretty_) { out_ += '\n'; spaces(current_indent()); }
+}
+
+void Writer::key(std::string_view k) {
+    before_value();
+    write_string(k);
+    out_ += pretty_ ? ": " : ":";
+    after_key_ = true;
+}
+
+void Writer::open(char c) {
+    before_value();
+    out_ += c;
+    levels_.push_back(0);
+}
+
+void Writer::close(char c) {
+    bool had_items = !levels_.empty() && levels_.back();
+    if (!levels_.empty()) levels_.pop_back();
+    if (pretty_ && had_items) { out_ += '\n'; spaces(current_indent()); }
+    out_ += c;
+}
+
+void Writer::start_object() { open('{'); }
+void Writer::end_object() { close('}'); }
+void Writer::start_array() { open('['); }
+void Writer::end_array() { close(']'); }
+
+std::string stringify(const Value& v, bool pretty, int indent_level) {
+    std::string out;
+    Writer w(out, pretty, indent_level);
+    w.value(v);
+    return out;
+}
+
+std::string stringify(const Node& v, bool pretty, int indent_level) {
+    std::string out;
+    Writer w(out, pretty, indent_level);
+    w.value(v);
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// Compact document
+
+void* Arena::alloc(size_t n, size_t align) {
+    size_t pad = (size_t)(-(uintptr_t)cur_) & (align - 1);
+    if (n + pad > left_) {
+        size_t sz = std::max(block_size_, n + align);
+        block_size_ = std::max<size_t>(sz * 2, 4096);
+        blocks_.emplace_back(new char[sz]);
+        cur_ = blocks_.back().get();
+        left_ = sz;
+        reserved_ += sz;
+        pad = (size_t)(-(uintptr_t)cur_) & (align - 1);
+    }
+    char* p = cur_ + pad;
+    cur_ += pad + n;
+    left_ -= pad + n;
+    used_ += n;
+    return p;
+}
+
+const Node* Node::find(std::string_view k) const {
+    if (!is_object()) return nullptr;
+    for (const Member* m = members; m != members + len; ++m) {
+        if (m->key == k) return &m->value;
+    }
+    return nullptr;
+}
+
+const Node& Node::at(std::string_view k) const {
+    const Node* n = find(k);
+    if (!n) throw std::runtime_error("missing key: " + std::string(k));
+    return *n;
+}
+
+Value Node::to_value() const {
+    switch (type) {
+        case Value::Type::Null: return Value::nullv();
+        case Value::Type::Bool: return Value::boolean(b);
+        case Value::Type::Number: return Value::number(num);
+        case Value::Type::String: return Value::string(std::string(str, len));
+        case Value::Type::Array: {
+            std::vector<Value> arr;
+            arr.reserve(len);
+            for (const Node& n : *this) arr.push_back(n.to_value());
+            return Value::array(std::move(arr));
+        }
+        case Value::Type::Object: {
+            std::map<std::string, Value> obj;
+            for (const Member* m = members; m != members + len; ++m) {
+                obj.emplace(std::string(m->key), m->value.to_value());
+            }
+            return Value::object(std::move(obj));
+        }
+    }
+    return Value::nullv();
+}
+
+// Builds Nodes directly into the arena. Children are collected on scratch
+// stacks (reused per thread) and copied out contiguously when their
+// container closes.
+struct DocParser {
+    std::string_view t;
+    Arena& arena;
+    std::vector<Node>& node_stack;
+    std::vector<Member>& member_stack;
+    size_t i = 0;
+    int depth = 0;
+
+    void ws() { skip_ws(t, i); }
+    char peek() { ws(); return (i < t.size()) ? t[i] : '\0'; }
+    char get() { if (i >= t.size()) return '\0'; return t[i++]; }
+
+    void expect(char c) {
+        ws();
+        if (get() != c) throw std::runtime_error(std::string("expected '") + c + "'");
+    }
+
+    void consume(const char* lit) {
+        ws();
+        for (const char* p=lit; *p; ++p) {
+            if (get() != *p) throw std::runtime_error(std::string("expected literal: ") + lit);
+        }
+    }
+
+    Node parse_value() {
+        Node n;
+        char c = peek();
+        if (c == '"') {
+            n.type = Value::Type::String;
+            std::string_view sv = parse_string();
+            n.str = sv.data();
+            n.len = (uint32_t)sv.size();
+        } else if (c == '{') {
+            parse_object(n);
+        } else if (c == '[') {
+            parse_array(n);
+        } else if (c == 't') { consume("true"); n.type = Value::Type::Bool; n.b = true; }
+        else if (c == 'f') { consume("false"); n.type = Value::Type::Bool; n.b = false; }
+        else if (c == 'n') { consume("null"); }
+        else if (c == '-' || std::isdigit((unsigned char)c)) { n.type = Value::Type::Number; n.num = parse_number(); }
+        else throw std::runtime_error("invalid json value");
+        return n;
+    }
+
+    // Returns a view into the source when the string has no escapes,
+    // otherwise the unescaped copy is placed in the arena.
+    std::string_view parse_string() {
+        ws();
+        if (get() != '"') throw std::runtime_error("expected string quote");
+        size_t start = i;
+        i += scan_fns().string_span(t.data() + i, t.data() + t.size());
+        if (i >= t.size()) throw std::runtime_error("unterminated string");
+        if (t[i] == '"') { return t.substr(start, i++ - start); }
+
+        thread_local std::string out;
+        out.assign(t.data() + start, i - start);
+        read_string_body(t, i, out);
+        char* p = (char*)arena.alloc(out.size(), 1);
+        std::memcpy(p, out.data(), out.size());
+        return std::string_view(p, out.size());
+    }
+
+    double parse_number() {
+        ws();
+        return read_number(t, i);
+    }
+
+    void parse_array(Node& n) {
+        expect('[');
+        enter_container(depth);
+        n.type = Value::Type::Array;
+        size_t base = node_stack.size();
+        if (peek() == ']') { get(); depth--; n.items = nullptr; n.len = 0; return; }
+        while (true) {
+            node_stack.push_back(parse_value());
+            ws();
+            char c = get();
+            if (c == ']') break;
+            if (c != ',') throw std::runtime_error("expected , or ]");
+        }
+        size_t cnt = node_stack.size() - base;
+        Node* dst = (Node*)arena.alloc(cnt * sizeof(Node), alignof(Node));
+        std::memcpy((void*)dst, node_stack.data() + base, cnt * sizeof(Node));
+        node_stack.resize(base);
+        depth--;
+        n.items = dst;
+        n.len = (uint32_t)cnt;
+    }
+
+    void parse_object(Node& n) {
+        expect('{');
+        enter_container(depth);
+        n.type = Value::Type::Object;
+        size_t base = member_stack.size();
+        if (peek() == '}') { get(); depth--; n.members = nullptr; n.len = 0; return; }
+        while (true) {
+            std::string_view key = parse_string();
+            expect(':');
+            Node val = parse_value();
+            member_stack.push_back(Member{key, val});
+            ws();
+            char c = get();
+            if (c == '}') break;
+            if (c != ',') throw std::runtime_error("expected , or }");
+        }
+        size_t cnt = member_stack.size() - base;
+        Member* dst = (Member*)arena.alloc(cnt * sizeof(Member), alignof(Member));
+        std::memcpy((void*)dst, member_stack.data() + base, cnt * sizeof(Member));
+        member_stack.resize(base);
+        depth--;
+        n.members = dst;
+        n.len = (uint32_t)cnt;
+    }
+};
+
+Document Document::parse(std::string_view text) {
+    thread_local std::vector<Node> node_stack;
+    thread_local std::vector<Member> member_stack;
+    node_stack.clear();
+    member_stack.clear();
+
+    Document doc;
+    // Node storage is roughly proportional to the text; one block usually fits.
+    doc.arena_.set_block_size(std::max<size_t>(256, text.size() * 2));
+    DocParser p{text, doc.arena_, node_stack, member_stack};
+    doc.root_ = p.parse_value();
+    p.ws();
+    if (p.i != text.size()) throw std::runtime_error("trailing data");
+    return doc;
+}
+
+// ---------------------------------------------------------------------------
+// Event parsing
+
+struct EventParser {
+    std::string_view t;
+    Handler& h;
+    std::string& scratch; // unescape buffer, reused per thread
+    size_t i = 0;
+    int depth = 0;
+
+    void ws() { skip_ws(t, i); }
+    char peek() { ws(); return (i < t.size()) ? t[i] : '\0'; }
+    char get() { if (i >= t.size()) return '\0'; return t[i++]; }
+
+    void expect(char c) {
+        ws();
+        if (get() != c) throw std::runtime_error(std::string("expected '") + c + "'");
+    }
+
+    void consume(const char* lit) {
+        ws();
+        for (const char* p=lit; *p; ++p) {
+            if (get() != *p) throw std::runtime_error(std::string("expected literal: ") + lit);
+        }
+    }
+
+    std::string_view parse_string() {
+        ws();
+        if (get() != '"') throw std::runtime_error("expected string quote");
+        size_t start = i;
+        i += scan_fns().string_span(t.data() + i, t.data() + t.size());
+        if (i >= t.size()) throw std::runtime_error("unterminated string");
+        if (t[i] == '"') { return t.substr(start, i++ - start); }
+        scratch.assign(t.data() + start, i - start);
+        read_string_body(t, i, scratch);
+        return scratch;
+    }
+
+    bool parse_value() {
+        char c = peek();
+        if (c == '"') return h.string(parse_string());
+        if (c == '{') return parse_object();
+        if (c == '[') return parse_array();
+        if (c == 't') { consume("true"); return h.boolean(true); }
+        if (c == 'f') { consume("false"); return h.boolean(false); }
+        if (c == 'n') { consume("null"); return h.null_value(); }
+        if (c == '-' || std::isdigit((unsigned char)c)) { ws(); return h.number(read_number(t, i)); }
+        throw std::runtime_error("invalid json value");
+    }
+
+    bool parse_array() {
+        expect('[');
+        enter_container(depth);
+        if (!h.start_array()) return false;
+        if (peek() == ']') { get(); depth--; return h.end_array(); }
+        while (true) {
+            if (!parse_value()) return false;
+            ws();
+            char c = get();
+            if (c == ']') break;
+            if (c != ',') throw std::runtime_error("expected , or ]");
+        }
+        depth--;
+        return h.end_array();
+    }
+
+    bool parse_object() {
+        expect('{');
+        enter_container(depth);
+        if (!h.start_object()) return false;
+        if (peek() == '}') { get(); depth--; return h.end_object(); }
+        while (true) {
+            if (!h.key(parse_string())) return false;
+            expect(':');
+            if (!parse_value()) return false;
+            ws();
+            char c = get();
+            if (c == '}') break;
+            if (c != ',') throw std::runtime_error("expected , or }");
+        }
+        depth--;
+        return h.end_object();
+    }
+};
+
+bool parse_events(std::string_view text, Handler& h) {
+    thread_local std::string scratch;
+    EventParser p{text, h, scratch};
+    if (!p.parse_value()) return false;
+    p.ws();
+    if (p.i != text.size()) throw std::runtime_error("trailing data");
+    return true;
 }
 
 } // namespace minijson
@@ -1,9 +1,13 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <cctype>
+#include <cstdint>
+#include <cstddef>
 
 namespace minijson {
 
@@ -35,7 +39,176 @@ struct Value {
     bool has(const std::string& k) const;
 };
 
+// Throws std::runtime_error on malformed input, including unterminated
+// strings and nesting deeper than 512 arrays / objects.
 Value parse(const std::string& text);
 std::string stringify(const Value& v, bool pretty=false, int indent=0);
 
+// Byte-scanning backend used by both parsers. Chosen at startup from the
+// CPU's capabilities; set_scan_impl (for benchmarks) returns false when the
+// requested implementation is not available.
+enum class ScanImpl { Scalar, SSE2, AVX2 };
+ScanImpl scan_impl();
+bool set_scan_impl(ScanImpl impl);
+const char* scan_impl_name(ScanImpl impl);
+
+// ---------------------------------------------------------------------------
+// Compact document representation.
+//
+// Nodes are 16-byte tagged values allocated from a per-document arena;
+// arrays and objects are contiguous runs of nodes / key-value members, and
+// strings without escapes are views into the source text. Offers the same
+// at/has/is_* accessors as Value.
+
+// Bump allocator; memory is released only when the arena is destroyed.
+class Arena {
+public:
+    Arena() = default;
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    void* alloc(size_t n, size_t align = alignof(std::max_align_t));
+    // Size of the next block to allocate; later blocks grow geometrically.
+    void set_block_size(size_t n) { block_size_ = n; }
+    size_t blocks() const { return blocks_.size(); }
+    size_t bytes_reserved() const { return reserved_; }
+    size_t bytes_used() const { return used_; }
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* cur_ = nullptr;
+    size_t left_ = 0;
+    size_t block_size_ = 4096;
+    size_t reserved_ = 0;
+    size_t used_ = 0;
+};
+
+struct Member;
+
+struct Node {
+    Value::Type type = Value::Type::Null;
+    uint32_t len = 0; // string bytes or element count
+    union {
+        bool b;
+        double num;
+        const char* str;
+        const Node* items;
+        const Member* members;
+    };
+
+    Node(): num(0.0) {}
+
+    bool is_null() const { return type == Value::Type::Null; }
+    bool is_bool() const { return type == Value::Type::Bool; }
+    bool is_number() const { return type == Value::Type::Number; }
+    bool is_string() const { return type == Value::Type::String; }
+    bool is_array() const { return type == Value::Type::Array; }
+    bool is_object() const { return type == Value::Type::Object; }
+
+    std::string_view string() const { return is_string() ? std::string_view(str, len) : std::string_view(); }
+    size_t size() const { return (is_array() || is_object()) ? len : 0; }
+
+    // Array elements.
+    const Node* begin() const { return is_array() ? items : nullptr; }
+    const Node* end() const { return is_array() ? items + len : nullptr; }
+    const Node& operator[](size_t i) const { return items[i]; }
+
+    // Object members, in source order.
+    const Member* members_begin() const { return is_object() ? members : nullptr; }
+    const Member* members_end() const;
+
+    const Node* find(std::string_view k) const;
+    const Node& at(std::string_view k) const;
+    bool has(std::string_view k) const { return find(k) != nullptr; }
+
+    Value to_value() const;
+};
+
+struct Member {
+    std::string_view key;
+    Node value;
+};
+
+inline const Member* Node::members_end() const { return is_object() ? members + len : nullptr; }
+
+class Document {
+public:
+    // The document may point into `text`, which must outlive it.
+    static Document parse(std::string_view text);
+
+    const Node& root() const { return root_; }
+    const Arena& arena() const { return arena_; }
+
+private:
+    Arena arena_;
+    Node root_;
+};
+
+std::string stringify(const Node& v, bool pretty=false, int indent=0);
+
+// ---------------------------------------------------------------------------
+// Serialisation into a caller-owned buffer. Appends (never clears), so one
+// buffer can be reused across documents and grow once. Output is identical
+// to stringify(), which is a thin wrapper around this.
+
+class Writer {
+public:
+    // indent is the starting indentation for pretty output, as in stringify.
+    explicit Writer(std::string& out, bool pretty = false, int indent = 0);
+
+    void value(const Value& v);
+    void value(const Node& v);
+
+    // Incremental building; separators and pretty layout are handled here.
+    void null_value();
+    void boolean(bool b);
+    void number(double d);
+    void string(std::string_view s);
+    void key(std::string_view k);
+    void start_object();
+    void end_object();
+    void start_array();
+    void end_array();
+
+private:
+    void write(const Value& v, int ind);
+    void write(const Node& v, int ind);
+    void write_string(std::string_view s);
+    void write_number(double d);
+    void spaces(int n);
+    void before_value();
+    void open(char c);
+    void close(char c);
+    int current_indent() const;
+
+    std::string& out_;
+    bool pretty_;
+    int base_indent_;
+    bool after_key_ = false;
+    std::vector<unsigned char> levels_; // per open container: has items
+};
+
+// ---------------------------------------------------------------------------
+// Event (SAX-style) parsing: reports values to a Handler as they are scanned
+// and never builds a tree. String views are only valid during the callback.
+// Returning false from a callback stops parsing.
+
+class Handler {
+public:
+    virtual ~Handler() = default;
+    virtual bool null_value() { return true; }
+    virtual bool boolean(bool) { return true; }
+    virtual bool number(double) { return true; }
+    virtual bool string(std::string_view) { return true; }
+    virtual bool key(std::string_view) { return true; }
+    virtual bool start_object() { return true; }
+    virtual bool end_object() { return true; }
+    virtual bool start_array() { return true; }
+    virtual bool end_array() { return true; }
+};
+
+// Returns false if the handler stopped early; throws std::runtime_error on
+// malformed input, like parse().
+bool parse_events(std::string_view text, Handler& h);
+
 } // namespace minijson
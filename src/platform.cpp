@@ -5,6 +5,7 @@
 #include <sstream>
 #include <fstream>
 #include <cstring>
+#include <ctime>
 
 #if defined(_MSC_VER)
   #include <intrin.h>
@@ -18,10 +19,12 @@
   #endif
   #include <windows.h>
   #include <Lmcons.h>
+  #include <psapi.h>
 #else
   #include <unistd.h>
   #include <sys/utsname.h>
   #include <sys/sysinfo.h>
+  #include <sys/resource.h>
 #endif
 
 namespace platforminfo {
@@ -205,12 +208,48 @@ std::string now_iso_utc() {
     gmtime_r(&t, &tm);
 #endif
     char buf[32];
-    std::snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d:%02d:%02dZ",
-                  tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
-                  tm.tm_hour, tm.tm_min, tm.tm_sec);
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
     return buf;
 }
 
+long long static_facts_stamp() {
+#ifdef _WIN32
+    return 0;
+#else
+    std::error_code ec;
+    auto t = std::filesystem::last_write_time("/etc/os-release", ec);
+    if (ec) return 0;
+    return (long long)t.time_since_epoch().count();
+#endif
+}
+
+ProcessUsage process_usage() {
+    ProcessUsage u;
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        u.max_rss_kb = (long long)(pmc.PeakWorkingSetSize / 1024);
+    }
+    FILETIME created, exited, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+        auto ticks = [](const FILETIME& f) { return ((unsigned long long)f.dwHighDateTime << 32) | f.dwLowDateTime; };
+        u.cpu_seconds = (double)(ticks(kernel) + ticks(user)) / 1e7; // 100 ns units
+    }
+#else
+    struct rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+    #ifdef __APPLE__
+        u.max_rss_kb = (long long)ru.ru_maxrss / 1024; // bytes on macOS
+    #else
+        u.max_rss_kb = (long long)ru.ru_maxrss;
+    #endif
+        u.cpu_seconds = (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+                        (double)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+    }
+#endif
+    return u;
+}
+
 } // namespace platforminfo
 
 
@@ -20,4 +20,17 @@ std::vector<DiskInfo> disks();
 
 std::string now_iso_utc();
 
+// Changes when the facts read from files (os_name, cpu_brand) may have
+// changed: the modification time of /etc/os-release (0 on Windows and when
+// the file is missing). Costs one stat, no parsing.
+long long static_facts_stamp();
+
+// Resource usage of this process so far: peak resident set and user+system
+// CPU time.
+struct ProcessUsage {
+    long long max_rss_kb = -1;
+    double cpu_seconds = -1;
+};
+ProcessUsage process_usage();
+
 } // namespace platforminfo
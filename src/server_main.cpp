@@ -1,13 +1,79 @@
 #include "http_server.hpp"
+#include "asset_binary.hpp"
 #include "logger.hpp"
 #include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// asset_server --convert IN OUT: binary -> JSONL when IN has the binary
+// header, otherwise (segmented) JSONL store -> binary.
+static int convert(const std::string& in, const std::string& out) {
+    size_t n = 0;
+    std::string err;
+    bool ok = assetbin::is_binary_file(in) ? assetbin::binary_to_jsonl(in, out, n, err)
+                                           : assetbin::jsonl_to_binary(in, out, n, err);
+    if (!ok) {
+        logutil::error("convert", err);
+        return 1;
+    }
+    std::cout << "converted " << n << " records: " << in << " -> " << out << "\n";
+    return 0;
+}
 
 int main(int argc, char** argv) {
     logutil::ensure_dirs();
-    int port = 8080;
-    if (argc >= 2) {
-        port = std::atoi(argv[1]);
-        if (port <= 0) port = 8080;
+    httpserver::Options opt;
+    opt.store.segment_bytes = 64ull << 20;
+    logutil::Options log_opt;
+    std::vector<std::string> bad_flags;
+    for (int i=1;i<argc;i++) {
+        std::string a = argv[i];
+        if (a == "--convert" && i + 2 < argc) return convert(argv[i + 1], argv[i + 2]);
+        else if (a == "--threads" && i + 1 < argc) opt.threads = std::atoi(argv[++i]);
+        else if (a == "--single-thread") opt.single_thread = true;
+        else if (a == "--backlog" && i + 1 < argc) opt.backlog = std::atoi(argv[++i]);
+        else if (a == "--idle-timeout" && i + 1 < argc) opt.idle_timeout_ms = std::atoi(argv[++i]);
+        else if (a == "--max-requests" && i + 1 < argc) opt.max_requests_per_conn = std::atoi(argv[++i]);
+        else if (a == "--no-keepalive") opt.keep_alive = false;
+        else if (a == "--fsync" && i + 1 < argc) {
+            std::string p = argv[++i];
+            if (p == "none") opt.store.sync = filestore::SyncPolicy::None;
+            else if (p == "interval") opt.store.sync = filestore::SyncPolicy::Interval;
+            else if (p == "batch") opt.store.sync = filestore::SyncPolicy::Batch;
+            else bad_flags.push_back("--fsync tidak valid (none|interval|batch): " + p);
+        }
+        else if (a == "--fsync-interval" && i + 1 < argc) opt.store.sync_interval_ms = std::atoi(argv[++i]);
+        else if (a == "--strict-durability") opt.store.strict = true;
+        else if (a == "--segment-mb" && i + 1 < argc) opt.store.segment_bytes = (uint64_t)std::atoll(argv[++i]) << 20;
+        else if (a == "--segment-minutes" && i + 1 < argc) opt.store.segment_seconds = std::atoi(argv[++i]) * 60;
+        else if (a == "--compact-interval" && i + 1 < argc) opt.compact_interval_s = std::atoi(argv[++i]);
+        else if (a == "--compact-history") opt.compact_history = true;
+        else if (a == "--stream-min-assets" && i + 1 < argc) opt.stream_min_assets = (size_t)std::atoll(argv[++i]);
+        else if (a == "--no-gzip") opt.gzip = false;
+        else if (a == "--no-metrics") opt.metrics = false;
+        else if (a == "--log-queue" && i + 1 < argc) log_opt.capacity = (size_t)std::atoll(argv[++i]);
+        else if (a == "--log-block") log_opt.block_when_full = true;
+        else if (a == "--log-level" && i + 1 < argc) {
+            std::string l = argv[++i];
+            if (!logutil::parse_level(l, log_opt.level)) bad_flags.push_back("--log-level tidak valid (debug|info|warn|error|off): " + l);
+        }
+        else if (a == "--log-format" && i + 1 < argc) {
+            std::string f = argv[++i];
+            if (f == "json") log_opt.format = logutil::Format::Json;
+            else if (f == "text") log_opt.format = logutil::Format::Text;
+            else bad_flags.push_back("--log-format tidak valid (json|text): " + f);
+        }
+        else if (a == "--log-max-mb" && i + 1 < argc) log_opt.max_bytes = (uint64_t)std::atoll(argv[++i]) << 20;
+        else if (a == "--log-rotate-hours" && i + 1 < argc) log_opt.rotate_seconds = (int64_t)std::atoll(argv[++i]) * 3600;
+        else if (a == "--log-keep" && i + 1 < argc) log_opt.keep_files = std::atoi(argv[++i]);
+        else if (i == 1) opt.port = std::atoi(argv[i]);
     }
-    return httpserver::run(port);
+    // Before the first message: the logger starts with it.
+    logutil::configure(log_opt);
+    for (const auto& w : bad_flags) logutil::warn("server", w);
+    if (opt.port <= 0) opt.port = 8080;
+    if (opt.threads < 0) opt.threads = 0;
+    if (opt.backlog <= 0) opt.backlog = 1024;
+    return httpserver::run(opt);
 }
@@ -0,0 +1,87 @@
+// Round trip of the store converters: JSONL -> binary -> JSONL must give back
+// every valid record unchanged, across enough records that both converters
+// refill and flush their buffers several times.
+#include "asset_binary.hpp"
+#include "mini_json.hpp"
+#include "check.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static minijson::Value record(int i) {
+    using minijson::Value;
+    std::vector<Value> disks;
+    for (int d=0; d<1 + i % 3; d++) {
+        disks.push_back(Value::object({
+            {"mount", Value::string(d == 0 ? "/" : "/data" + std::to_string(d))},
+            {"total_gb", Value::number(100.0 * (d + 1))},
+            {"free_gb", Value::number(12.5 + i % 97 + d * 0.1)}
+        }));
+    }
+    return Value::object({
+        {"asset_id", Value::string("asset-" + std::to_string(i))},
+        {"hostname", Value::string("host-" + std::to_string(i))},
+        {"os", Value::string(i % 2 ? "Ubuntu 22.04" : "Debian 12 \"bookworm\"")},
+        {"cpu_model", Value::string("CPU model " + std::to_string(i % 5))},
+        {"cpu_cores", Value::number(2 + i % 8)},
+        {"ram_total_mb", Value::number(1024.0 * (1 + i % 16))},
+        {"disks", Value::array(std::move(disks))},
+        {"timestamp_utc", Value::string("2024-01-01T00:00:" + std::to_string(10 + i % 50) + "Z")},
+        {"agent_version", Value::string(i % 3 ? "1.2.0" : "1.3.0")}
+    });
+}
+
+static std::vector<std::string> read_lines(const fs::path& p) {
+    std::vector<std::string> out;
+    std::ifstream f(p, std::ios::binary);
+    for (std::string line; std::getline(f, line);) out.push_back(line);
+    return out;
+}
+
+static void round_trip(const fs::path& dir) {
+    const fs::path jsonl = dir / "assets.jsonl";
+    const fs::path bin = dir / "assets.bin";
+    const fs::path back = dir / "assets.back.jsonl";
+    const int n = 20000;
+
+    std::vector<std::string> expected;
+    {
+        std::ofstream f(jsonl, std::ios::binary | std::ios::trunc);
+        for (int i=0; i<n; i++) {
+            expected.push_back(minijson::stringify(record(i)));
+            f << expected.back() << "\n";
+            if (i % 1000 == 0) f << "{\"asset_id\":\"no-schema\"}\nnot json\n"; // skipped
+        }
+    }
+
+    size_t records = 0;
+    std::string err;
+    CHECK(assetbin::jsonl_to_binary(jsonl.string(), bin.string(), records, err));
+    CHECK(records == (size_t)n);
+    CHECK(assetbin::is_binary_file(bin.string()));
+    CHECK(fs::file_size(bin) < fs::file_size(jsonl));
+
+    CHECK(assetbin::binary_to_jsonl(bin.string(), back.string(), records, err));
+    CHECK(err.empty());
+    CHECK(records == (size_t)n);
+    CHECK(read_lines(back) == expected);
+
+    // A binary file cut inside an entry is reported, not read as shorter.
+    fs::resize_file(bin, fs::file_size(bin) - 3);
+    CHECK(!assetbin::binary_to_jsonl(bin.string(), back.string(), records, err));
+    CHECK(!err.empty());
+
+    CHECK(!assetbin::binary_to_jsonl(jsonl.string(), back.string(), records, err));
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / "asset_binary_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    round_trip(dir);
+    fs::remove_all(dir);
+    return check_result("asset_binary_test");
+}
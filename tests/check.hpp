@@ -0,0 +1,19 @@
+// Minimal harness shared by the test programs: CHECK records a failure and
+// keeps going, check_result turns the count into main's exit code.
+#pragma once
+#include <cstdio>
+
+inline int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); g_failures++; } \
+} while (0)
+
+inline int check_result(const char* name) {
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("%s: ok\n", name);
+    return 0;
+}
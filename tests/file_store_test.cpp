@@ -0,0 +1,168 @@
+// Crash-safety of the segmented store: every state an interrupted rollover
+// or compaction can leave behind must read back as the same records, and
+// opening an AppendWriter must remove the leftovers.
+#include "file_store.hpp"
+#include "mini_json.hpp"
+#include "check.hpp"
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static std::string record(const std::string& id, int v) {
+    return "{\"asset_id\":\"" + id + "\",\"v\":" + std::to_string(v) + "}";
+}
+
+static void write_file(const fs::path& p, const std::vector<std::string>& lines) {
+    std::ofstream f(p, std::ios::binary | std::ios::trunc);
+    for (const auto& l : lines) f << l << "\n";
+}
+
+static fs::path fresh_dir(const char* name) {
+    fs::path dir = fs::temp_directory_path() / "asset_file_store_test" / name;
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+static bool asset_key(std::string_view line, std::string& key) {
+    try {
+        key = std::string(minijson::Document::parse(line).root().at("asset_id").string());
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+// Reads the store and checks that folding its records in order yields
+// exactly `latest` (asset_id -> v) from exactly `lines` records.
+static void check_store(const std::string& path, const std::map<std::string, int>& latest, size_t lines) {
+    std::map<std::string, int> seen;
+    size_t n = 0;
+    uint64_t last_pos = 0;
+    filestore::for_each_record(path, [&](std::string_view line, uint64_t pos) {
+        auto doc = minijson::Document::parse(line);
+        seen[std::string(doc.root().at("asset_id").string())] = (int)doc.root().at("v").num;
+        CHECK(n == 0 || pos > last_pos);
+        last_pos = pos;
+        n++;
+    });
+    CHECK(seen == latest);
+    CHECK(n == lines);
+}
+
+static void open_writer(const std::string& path) {
+    filestore::AppendWriter w(path, filestore::WriterOptions{});
+    std::string err;
+    CHECK(w.open(err));
+}
+
+// A snapshot temporary from a compaction that died while writing it.
+static void leftover_tmp() {
+    fs::path dir = fresh_dir("leftover_tmp");
+    const std::string path = (dir / "assets.jsonl").string();
+    write_file(dir / "assets.00000000.jsonl", {record("a1", 1), record("a2", 1)});
+    write_file(dir / "assets.snapshot.00000000.jsonl.tmp", {record("a1", 99)});
+    write_file(path, {record("a1", 2)});
+
+    check_store(path, {{"a1", 2}, {"a2", 1}}, 3);
+    open_writer(path);
+    CHECK(!fs::exists(dir / "assets.snapshot.00000000.jsonl.tmp"));
+    CHECK(fs::exists(dir / "assets.00000000.jsonl"));
+    check_store(path, {{"a1", 2}, {"a2", 1}}, 3);
+}
+
+// A compaction that renamed its snapshot into place but died before
+// deleting the one it replaced.
+static void old_snapshot() {
+    fs::path dir = fresh_dir("old_snapshot");
+    const std::string path = (dir / "assets.jsonl").string();
+    write_file(dir / "assets.snapshot.00000001.jsonl", {record("a1", 1), record("a2", 1)});
+    write_file(dir / "assets.snapshot.00000003.jsonl", {record("a1", 2), record("a2", 2)});
+    write_file(dir / "assets.00000004.jsonl", {record("a2", 3)});
+    write_file(path, {record("a1", 4)});
+
+    check_store(path, {{"a1", 4}, {"a2", 3}}, 4);
+    open_writer(path);
+    CHECK(!fs::exists(dir / "assets.snapshot.00000001.jsonl"));
+    CHECK(fs::exists(dir / "assets.snapshot.00000003.jsonl"));
+    check_store(path, {{"a1", 4}, {"a2", 3}}, 4);
+}
+
+// ... or before deleting the sealed segments it folded in.
+static void folded_segments() {
+    fs::path dir = fresh_dir("folded_segments");
+    const std::string path = (dir / "assets.jsonl").string();
+    write_file(dir / "assets.00000001.jsonl", {record("a1", 1)});
+    write_file(dir / "assets.00000002.jsonl", {record("a2", 2), record("a1", 2)});
+    write_file(dir / "assets.snapshot.00000002.jsonl", {record("a2", 2), record("a1", 2)});
+    write_file(dir / "assets.00000003.jsonl", {record("a2", 3)});
+
+    check_store(path, {{"a1", 2}, {"a2", 3}}, 3);
+    open_writer(path);
+    CHECK(!fs::exists(dir / "assets.00000001.jsonl"));
+    CHECK(!fs::exists(dir / "assets.00000002.jsonl"));
+    CHECK(fs::exists(dir / "assets.00000003.jsonl"));
+    check_store(path, {{"a1", 2}, {"a2", 3}}, 3);
+}
+
+// A compaction killed after syncing its snapshot but before the rename:
+// the complete .tmp sits next to all of its inputs.
+static void killed_before_rename() {
+    fs::path dir = fresh_dir("killed_before_rename");
+    const std::string path = (dir / "assets.jsonl").string();
+    std::map<std::string, int> latest;
+    size_t lines = 0;
+    {
+        filestore::WriterOptions opt;
+        opt.segment_bytes = 64; // a rollover every couple of records
+        filestore::AppendWriter w(path, opt);
+        std::string err;
+        CHECK(w.open(err));
+        for (int v=1; v<=5; v++) {
+            for (const char* id : {"a1", "a2", "a3"}) {
+                CHECK(w.append(record(id, v), err));
+                latest[id] = v;
+                lines++;
+            }
+        }
+        CHECK(w.rollovers() > 1);
+    }
+
+    // Run the compaction on a copy, then put the inputs back and turn the
+    // finished snapshot into the temporary it was before the rename.
+    fs::path saved = dir / "saved";
+    fs::create_directories(saved);
+    for (const auto& seg : filestore::list_segments(path)) {
+        if (seg.kind == filestore::Segment::Kind::Sealed) fs::copy_file(seg.path, saved / fs::path(seg.path).filename());
+    }
+    filestore::CompactStats st;
+    std::string err;
+    CHECK(filestore::compact(path, asset_key, st, err));
+    CHECK(st.segments > 0);
+    const fs::path snapshot = filestore::list_segments(path).front().path;
+    fs::rename(snapshot, snapshot.string() + ".tmp");
+    for (const auto& e : fs::directory_iterator(saved)) fs::rename(e.path(), dir / e.path().filename());
+    fs::remove(saved);
+
+    check_store(path, latest, lines);
+    open_writer(path);
+    CHECK(!fs::exists(snapshot.string() + ".tmp"));
+    check_store(path, latest, lines);
+
+    // Compacting again from the intact inputs still converges.
+    CHECK(filestore::compact(path, asset_key, st, err));
+    check_store(path, latest, latest.size() + (lines - st.lines_in));
+}
+
+int main() {
+    leftover_tmp();
+    old_snapshot();
+    folded_segments();
+    killed_before_rename();
+    fs::remove_all(fs::temp_directory_path() / "asset_file_store_test");
+    return check_result("file_store_test");
+}
@@ -0,0 +1,159 @@
+// Incremental HTTP parser: messages fed a byte at a time must parse the same
+// as whole ones, pipelined requests must split at consumed(), and malformed
+// or oversized input must fail with the status the server sends back.
+#include "http_parser.hpp"
+#include "check.hpp"
+#include <string>
+
+using httpparser::Kind;
+using httpparser::Parser;
+using httpparser::Status;
+
+// Grows the buffer one byte per call, as a slow client would.
+static Status feed_bytewise(Parser& p, const std::string& msg, bool& early) {
+    early = false;
+    for (size_t i=1; i<=msg.size(); i++) {
+        Status s = p.parse(std::string_view(msg.data(), i));
+        if (s != Status::Incomplete) {
+            early = i != msg.size();
+            return s;
+        }
+    }
+    return Status::Incomplete;
+}
+
+static void split_reads() {
+    const std::string msg =
+        "POST /api/assets?x=1 HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "Content-Length: 11\r\n"
+        "Content-Type:application/json  \r\n"
+        "\r\n"
+        "{\"a\":\"b c\"}";
+    Parser p;
+    bool early = false;
+    CHECK(feed_bytewise(p, msg, early) == Status::Complete);
+    CHECK(!early);
+    const auto& r = p.request();
+    CHECK(r.method == "POST");
+    CHECK(r.path() == "/api/assets");
+    CHECK(r.query() == "x=1");
+    CHECK(r.version == "HTTP/1.1");
+    CHECK(r.headers.size() == 3);
+    CHECK(r.header("content-type") == "application/json");
+    CHECK(r.body == "{\"a\":\"b c\"}");
+    CHECK(r.keep_alive());
+    CHECK(p.consumed() == msg.size());
+}
+
+static void chunked() {
+    const std::string msg =
+        "POST /api/assets HTTP/1.1\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "Connection: close\r\n"
+        "\r\n"
+        "5;name=value\r\n"
+        "hello\r\n"
+        "A \r\n"
+        ", chunked!\r\n"
+        "0\r\n"
+        "X-Checksum: abc\r\n"
+        "X-Other: 1\r\n"
+        "\r\n";
+    Parser p;
+    bool early = false;
+    CHECK(feed_bytewise(p, msg, early) == Status::Complete);
+    CHECK(!early);
+    CHECK(p.request().body == "hello, chunked!");
+    CHECK(!p.request().keep_alive());
+    CHECK(p.consumed() == msg.size());
+
+    Parser whole;
+    CHECK(whole.parse(msg) == Status::Complete);
+    CHECK(whole.request().body == "hello, chunked!");
+}
+
+static void pipelining() {
+    const std::string first = "POST /a HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc";
+    const std::string second = "GET /b HTTP/1.1\r\nHost: x\r\n\r\n";
+    const std::string third = "POST /c HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nhi\r\n0\r\n\r\n";
+    std::string buf = first + second + third + "GET /d HT";
+
+    Parser p;
+    CHECK(p.parse(buf) == Status::Complete);
+    CHECK(p.request().target == "/a");
+    CHECK(p.request().body == "abc");
+    CHECK(p.consumed() == first.size());
+    buf.erase(0, p.consumed());
+    p.reset();
+
+    CHECK(p.parse(buf) == Status::Complete);
+    CHECK(p.request().method == "GET");
+    CHECK(p.request().target == "/b");
+    CHECK(p.request().body.empty());
+    CHECK(p.consumed() == second.size());
+    buf.erase(0, p.consumed());
+    p.reset();
+
+    CHECK(p.parse(buf) == Status::Complete);
+    CHECK(p.request().target == "/c");
+    CHECK(p.request().body == "hi");
+    CHECK(p.consumed() == third.size());
+    buf.erase(0, p.consumed());
+    p.reset();
+
+    CHECK(p.parse(buf) == Status::Incomplete);
+    buf += "TP/1.0\r\n\r\n";
+    CHECK(p.parse(buf) == Status::Complete);
+    CHECK(p.request().target == "/d");
+    CHECK(!p.request().keep_alive());
+}
+
+static void expect_error(const std::string& msg, int status) {
+    Parser p;
+    CHECK(p.parse(msg) == Status::Error);
+    CHECK(p.error_status() == status);
+    CHECK(!p.error().empty());
+    // A failed parser stays failed.
+    CHECK(p.parse(msg) == Status::Error);
+}
+
+static void errors() {
+    const std::string too_big = std::to_string(Parser::kMaxBodyBytes + 1);
+    expect_error("POST / HTTP/1.1\r\nContent-Length: " + too_big + "\r\n\r\n", 413);
+    expect_error("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n400001\r\n", 413); // one byte over, in hex
+
+    expect_error("GET / HTTP/1.1\r\nHost localhost\r\n\r\n", 400);
+    expect_error("GET / HTTP/1.1\r\n: empty-name\r\n\r\n", 400);
+    expect_error("GET / HTTP/1.1\r\nX-A: 1\r\n folded\r\n\r\n", 400);
+    expect_error("GET /\r\n\r\n", 400);
+    expect_error("POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n", 400);
+    expect_error("POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n", 400);
+    expect_error("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", 400);
+    expect_error("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nhiX\r\n", 400);
+    expect_error("GET / HTTP/1.1\r\nX-Big: " + std::string(Parser::kMaxHeaderBytes, 'a'), 400);
+
+    // The header-line check also covers responses.
+    Parser r(Kind::Response);
+    CHECK(r.parse("HTTP/1.1 200 OK\r\nbroken\r\n\r\n") == Status::Error);
+    CHECK(r.error_status() == 400);
+}
+
+static void response_until_eof() {
+    const std::string msg = "HTTP/1.0 200 OK\r\nServer: t\r\n\r\nbody until close";
+    Parser p(Kind::Response);
+    CHECK(p.parse(msg) == Status::Incomplete);
+    CHECK(p.finish_at_eof(msg) == Status::Complete);
+    CHECK(p.response().status == 200);
+    CHECK(p.response().reason == "OK");
+    CHECK(p.response().body == "body until close");
+}
+
+int main() {
+    split_reads();
+    chunked();
+    pipelining();
+    errors();
+    response_until_eof();
+    return check_result("http_parser_test");
+}